@@ -0,0 +1,94 @@
+// shared timing harness for flux_bench.c and cxx_bench.cpp
+#ifndef FLUX_BENCH_COMMON_H
+#define FLUX_BENCH_COMMON_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define BENCH_NOINLINE __attribute__((noinline))
+
+typedef void (*bench_fn_t)(void* arg, long iters);
+
+typedef struct bench_job {
+    bench_fn_t fn;
+    void* arg;
+    long iters;
+    double ns;
+} bench_job_t;
+
+// one sink per thread, so N-thread runs do not contend on a shared line
+#ifdef __cplusplus
+static thread_local volatile long bench_sink;
+#else
+static _Thread_local volatile long bench_sink;
+#endif
+
+static inline double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void* bench_thread_main(void* p) {
+    bench_job_t* job = (bench_job_t*)p;
+    job->fn(job->arg, job->iters / 10 + 1);
+    double t0 = bench_now_ns();
+    job->fn(job->arg, job->iters);
+    job->ns = bench_now_ns() - t0;
+    return NULL;
+}
+
+static inline int bench_default_threads(void) {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 1 ? (int)n : 2;
+}
+
+// runs fn on `threads` threads at once and reports the mean ns per op,
+// where one op is one iteration divided by `ops_per_iter`
+static inline void bench_run(const char* impl, const char* name, bench_fn_t fn, void* arg,
+                             long iters, long ops_per_iter, int threads) {
+    bench_job_t* jobs = (bench_job_t*)calloc((size_t)threads, sizeof(bench_job_t));
+    pthread_t* tids = (pthread_t*)calloc((size_t)threads, sizeof(pthread_t));
+    if (!jobs || !tids) abort();
+    for (int i = 0; i < threads; i++) {
+        jobs[i].fn = fn;
+        jobs[i].arg = arg;
+        jobs[i].iters = iters;
+    }
+    if (threads == 1) {
+        bench_thread_main(&jobs[0]);
+    } else {
+        for (int i = 0; i < threads; i++) {
+            if (pthread_create(&tids[i], NULL, bench_thread_main, &jobs[i]) != 0) abort();
+        }
+        for (int i = 0; i < threads; i++) pthread_join(tids[i], NULL);
+    }
+    double total = 0;
+    for (int i = 0; i < threads; i++) total += jobs[i].ns;
+    double ns = total / threads / ((double)iters * (double)ops_per_iter);
+    printf("%-6s %-28s %3d thr  %10.2f ns/op\n", impl, name, threads, ns);
+    fflush(stdout);
+    free(jobs);
+    free(tids);
+}
+
+static inline long bench_iters_from_env(long def) {
+    const char* s = getenv("BENCH_ITERS");
+    if (!s) return def;
+    long v = strtol(s, NULL, 10);
+    return v > 0 ? v : def;
+}
+
+static inline int bench_threads_from_args(int argc, char** argv) {
+    if (argc > 1) {
+        int n = atoi(argv[1]);
+        if (n > 0) return n;
+    }
+    return bench_default_threads();
+}
+
+#endif /* FLUX_BENCH_COMMON_H */
@@ -0,0 +1,46 @@
+// main.c-style call sites used by bench/codesize.sh to measure macro expansion size
+// (total is volatile because it is written inside FLUX_TRY and read after a possible throw)
+#include "libflux.h"
+
+__attribute__((noinline)) size_t cs_malloc_loop(int n) {
+    volatile size_t total = 0;
+    FLUX_TRY {
+        for (int i = 0; i < n; i++) {
+            char* p = (char*)FLUX_MALLOC((size_t)i + 16);
+            p[0] = (char)i;
+            total += (size_t)p[0];
+        }
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+    } FLUX_END_TRY;
+    return total;
+}
+
+__attribute__((noinline)) size_t cs_mixed(const char* path, const char* name, int n) {
+    volatile size_t total = 0;
+    FLUX_TRY {
+        int* arr = (int*)FLUX_CALLOC((size_t)n, sizeof(int));
+        char* copy = FLUX_STRDUP(name);
+        char* buf = (char*)FLUX_MALLOC(256);
+        FILE* f = FLUX_FOPEN(path, "r");
+        if (!fgets(buf, 256, f)) FLUX_THROW_PARSE("empty file");
+        total = strlen(buf) + strlen(copy) + (size_t)arr[0];
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+    } FLUX_END_TRY;
+    return total;
+}
+
+__attribute__((noinline)) size_t cs_strdup_loop(const char* const* names, int n) {
+    volatile size_t total = 0;
+    FLUX_TRY {
+        for (int i = 0; i < n; i++) {
+            char* s = FLUX_STRDUP(names[i]);
+            if (!s[0]) FLUX_THROW_INVALID("empty name");
+            total += strlen(s);
+        }
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+    } FLUX_END_TRY;
+    return total;
+}
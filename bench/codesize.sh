@@ -0,0 +1,18 @@
+#!/bin/sh
+# reports the text size of main.c-style libflux usage; usage: bench/codesize.sh
+# CC and CFLAGS may be overridden from the environment
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${BENCH_OUT:-/tmp/libflux-bench}
+CC=${CC:-cc}
+CFLAGS=${CFLAGS:--O2}
+
+mkdir -p "$OUT"
+for src in main.c bench/codesize.c; do
+    obj="$OUT/$(basename "$src" .c).o"
+    $CC $CFLAGS -I"$ROOT" -c "$ROOT/$src" -o "$obj"
+    echo "== $src ($CC $CFLAGS)"
+    size "$obj" | tail -n 1 | awk '{ printf "text %d bytes\n", $1 }'
+    nm --size-sort -S -t d "$obj" | awk '$3 ~ /^[tT]$/ { printf "  %-32s %6d\n", $4, $2 }'
+done
@@ -0,0 +1,102 @@
+// C++ exceptions running the same workload as flux_bench.c
+// (loop counters are volatile, as in flux_bench.c, so both sides pay the same per-iteration cost)
+// build and run with bench/run.sh, or: c++ -O2 bench/cxx_bench.cpp -o cxx_bench -lpthread
+#include <stdexcept>
+#include <vector>
+#include "bench_common.h"
+
+#define DEFER_BATCH 64
+#define CXX_MAX_DEPTH 64
+
+struct noop_guard {
+    void* ptr;
+    explicit noop_guard(void* p) : ptr(p) {}
+    ~noop_guard() { __asm__ volatile("" : : "r"(ptr) : "memory"); }
+    noop_guard(const noop_guard&) = delete;
+    noop_guard& operator=(const noop_guard&) = delete;
+    noop_guard(noop_guard&& o) noexcept : ptr(o.ptr) { o.ptr = nullptr; }
+};
+
+static BENCH_NOINLINE void work_ok(int x) {
+    bench_sink += x;
+}
+
+static void cxx_try_enter(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        try {
+            work_ok((int)i);
+        } catch (const std::exception& e) {
+            (void)e;
+        }
+    }
+}
+
+static BENCH_NOINLINE void cxx_recurse(int d) {
+    if (d <= 1) throw std::invalid_argument("bench");
+    cxx_recurse(d - 1);
+    bench_sink++;
+}
+
+static void cxx_throw_depth(void* arg, long iters) {
+    int d = *(int*)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        try {
+            cxx_recurse(d);
+        } catch (const std::invalid_argument& e) {
+            bench_sink += 4;
+        }
+    }
+}
+
+static void cxx_defer(void* arg, long iters) {
+    (void)arg;
+    std::vector<noop_guard> guards;
+    guards.reserve(DEFER_BATCH);
+    for (volatile long i = 0; i < iters; i++) {
+        for (int k = 0; k < DEFER_BATCH; k++) guards.emplace_back((void*)&bench_sink);
+        guards.clear();
+    }
+}
+
+static void cxx_release(void* arg, long iters) {
+    int n = *(int*)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        try {
+            std::vector<noop_guard> guards;
+            guards.reserve((size_t)n);
+            for (int k = 0; k < n; k++) guards.emplace_back((void*)&bench_sink);
+            throw std::invalid_argument("bench");
+        } catch (const std::invalid_argument& e) {
+            (void)e;
+        }
+    }
+}
+
+static void run_all(int threads, long base) {
+    static const int depths[] = { 1, 4, 16, CXX_MAX_DEPTH };
+    static const int chains[] = { 1, 16, 256, 2048, 16384 };
+    char name[64];
+
+    bench_run("c++", "try_enter", cxx_try_enter, NULL, base * 10, 1, threads);
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        int d = depths[i];
+        snprintf(name, sizeof(name), "throw_depth_%d", d);
+        bench_run("c++", name, cxx_throw_depth, &d, base, 1, threads);
+    }
+    bench_run("c++", "defer", cxx_defer, NULL, base / 4, DEFER_BATCH, threads);
+    for (size_t i = 0; i < sizeof(chains) / sizeof(chains[0]); i++) {
+        int n = chains[i];
+        long it = base * 4 / n + 1;
+        snprintf(name, sizeof(name), "release_%d", n);
+        bench_run("c++", name, cxx_release, &n, it, n, threads);
+    }
+}
+
+int main(int argc, char** argv) {
+    int threads = bench_threads_from_args(argc, argv);
+    long base = bench_iters_from_env(200000);
+    run_all(1, base);
+    run_all(threads, base);
+    return 0;
+}
@@ -0,0 +1,335 @@
+// benchmark for libflux: FLUX_TRY / FLUX_THROW / FLUX_DEFER costs vs errno-return code
+// (loop counters are volatile, as in codesize.c, to keep -Wclobbered quiet around FLUX_TRY;
+// the errno baselines use the same form so both sides pay the same per-iteration cost)
+// build and run with bench/run.sh, or: cc -O2 -I. bench/flux_bench.c -o flux_bench -lpthread
+#include "libflux.h"
+#include "bench_common.h"
+
+#define DEFER_BATCH 64
+#define ALLOC_BATCH 256
+#define ALLOC_SIZE 48
+
+static void bench_noop_dtor(void* p) {
+    (void)p;
+}
+
+static BENCH_NOINLINE int work_ok(int x) {
+    bench_sink += x;
+    return 0;
+}
+
+/* ---- FLUX_TRY entry, success path ---- */
+
+static void flux_try_enter(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            work_ok((int)i);
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+static void errno_try_enter(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        if (work_ok((int)i) != 0) bench_sink--;
+    }
+}
+
+/* ---- FLUX_THROW through d call frames ---- */
+
+static BENCH_NOINLINE void flux_recurse(int d) {
+    if (d <= 0) return;
+    if (d == 1) FLUX_THROW_INVALID("bench");
+    flux_recurse(d - 1);
+    bench_sink++;
+}
+
+static void flux_throw_depth(void* arg, long iters) {
+    int d = *(int*)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            flux_recurse(d);
+        } FLUX_CATCH(e) {
+            bench_sink += e->code;
+        } FLUX_END_TRY;
+    }
+}
+
+static BENCH_NOINLINE int errno_recurse(int d) {
+    if (d <= 1) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (errno_recurse(d - 1) != 0) return -1;
+    bench_sink++;
+    return 0;
+}
+
+static void errno_throw_depth(void* arg, long iters) {
+    int d = *(int*)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        if (errno_recurse(d) != 0) bench_sink += errno;
+    }
+}
+
+/* ---- FLUX_THROW_ERRNO, caught without reading the message ---- */
+
+static BENCH_NOINLINE void flux_fail_errno(void) {
+    errno = ENOENT;
+    FLUX_THROW_ERRNO("bench");
+}
+
+static void flux_throw_errno(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            flux_fail_errno();
+        } FLUX_CATCH(e) {
+            bench_sink += e->code;
+        } FLUX_END_TRY;
+    }
+}
+
+static BENCH_NOINLINE int errno_fail(void) {
+    errno = ENOENT;
+    return -1;
+}
+
+static void errno_throw_errno(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        if (errno_fail() != 0) bench_sink += errno;
+    }
+}
+
+/* ---- FLUX_DEFER registration ---- */
+
+static void flux_defer(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            for (int k = 0; k < DEFER_BATCH; k++) {
+                FLUX_DEFER(bench_noop_dtor, &bench_sink);
+            }
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+/* ---- small allocations released at scope exit: FLUX_MALLOC vs FLUX_ARENA_ALLOC ---- */
+
+static void flux_malloc_small(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            for (int k = 0; k < ALLOC_BATCH; k++) {
+                char* p = (char*)FLUX_MALLOC(ALLOC_SIZE);
+                p[0] = (char)k;
+            }
+            FLUX_THROW_INVALID("bench");
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+static void flux_arena_small(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            for (int k = 0; k < ALLOC_BATCH; k++) {
+                char* p = (char*)FLUX_ARENA_ALLOC(ALLOC_SIZE);
+                p[0] = (char)k;
+            }
+            FLUX_THROW_INVALID("bench");
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+static void errno_malloc_small(void* arg, long iters) {
+    (void)arg;
+    char* ptrs[ALLOC_BATCH];
+    for (volatile long i = 0; i < iters; i++) {
+        for (int k = 0; k < ALLOC_BATCH; k++) {
+            ptrs[k] = (char*)malloc(ALLOC_SIZE);
+            if (!ptrs[k]) abort();
+            ptrs[k][0] = (char)k;
+        }
+        for (int k = ALLOC_BATCH - 1; k >= 0; k--) free(ptrs[k]);
+    }
+}
+
+/* ---- a typical small scope: two guards, normal exit ---- */
+
+static void flux_scope_small(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            FLUX_DEFER(bench_noop_dtor, &bench_sink);
+            FLUX_DEFER(bench_noop_dtor, &bench_sink);
+            work_ok((int)i);
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+/* ---- per-scope lookup table: 1024 int keys inserted, then found ---- */
+
+#define MAP_KEYS 1024
+
+static void flux_map_int_1k(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            flux_map_t* m = flux_map_new_int(MAP_KEYS);
+            for (uint64_t k = 0; k < MAP_KEYS; k++) flux_map_put_int(m, k * 2654435761u, (void*)&bench_sink);
+            for (uint64_t k = 0; k < MAP_KEYS; k++) bench_sink += flux_map_find_int(m, k * 2654435761u) != NULL;
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+/* ---- building a line of text: flux_sb vs FLUX_MALLOC + snprintf ---- */
+
+#define SB_FIELDS 16
+
+static void flux_sb_line(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            flux_sb_t sb;
+            flux_sb_init(&sb, 0);
+            for (int k = 0; k < SB_FIELDS; k++) {
+                flux_sb_append(&sb, "id=");
+                flux_sb_append_int(&sb, i * k);
+                flux_sb_append(&sb, " v=");
+                flux_sb_append_double(&sb, (double)k * 0.37, 3);
+                flux_sb_putc(&sb, ';');
+            }
+            bench_sink += (long)sb.len;
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+static void flux_snprintf_line(void* arg, long iters) {
+    (void)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            char* buf = (char*)FLUX_MALLOC(1024);
+            size_t len = 0;
+            for (int k = 0; k < SB_FIELDS; k++) {
+                len += (size_t)snprintf(buf + len, 1024 - len, "id=%ld v=%.3f;", i * k, (double)k * 0.37);
+            }
+            bench_sink += (long)len;
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+typedef struct errno_cleanup {
+    void (*fn)(void*);
+    void* ptr;
+} errno_cleanup_t;
+
+static void errno_defer(void* arg, long iters) {
+    (void)arg;
+    errno_cleanup_t cl[DEFER_BATCH];
+    for (volatile long i = 0; i < iters; i++) {
+        int n = 0;
+        for (int k = 0; k < DEFER_BATCH; k++) {
+            cl[n].fn = bench_noop_dtor;
+            cl[n].ptr = (void*)&bench_sink;
+            n++;
+        }
+        __asm__ volatile("" : : "r"(cl) : "memory");
+    }
+}
+
+/* ---- guard release on the error path, chains of n guards ---- */
+
+static void flux_release(void* arg, long iters) {
+    int n = *(int*)arg;
+    for (volatile long i = 0; i < iters; i++) {
+        FLUX_TRY {
+            for (int k = 0; k < n; k++) {
+                FLUX_DEFER(bench_noop_dtor, &bench_sink);
+            }
+            FLUX_THROW_INVALID("bench");
+        } FLUX_CATCH(e) {
+            (void)e;
+        } FLUX_END_TRY;
+    }
+}
+
+static void errno_release(void* arg, long iters) {
+    int n = *(int*)arg;
+    errno_cleanup_t* cl = (errno_cleanup_t*)malloc(sizeof(errno_cleanup_t) * (size_t)n);
+    if (!cl) abort();
+    for (volatile long i = 0; i < iters; i++) {
+        for (int k = 0; k < n; k++) {
+            cl[k].fn = bench_noop_dtor;
+            cl[k].ptr = (void*)&bench_sink;
+        }
+        __asm__ volatile("" : : "r"(cl) : "memory");
+        for (int k = n - 1; k >= 0; k--) cl[k].fn(cl[k].ptr);
+    }
+    free(cl);
+}
+
+static void run_all(int threads, long base) {
+    static const int depths[] = { 1, 4, 16, FLUX_MAX_DEPTH };
+    static const int chains[] = { 1, 16, 256, 2048, 16384 };
+    char name[64];
+
+    bench_run("flux", "try_enter", flux_try_enter, NULL, base * 10, 1, threads);
+    bench_run("errno", "try_enter", errno_try_enter, NULL, base * 10, 1, threads);
+
+    for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+        int d = depths[i];
+        snprintf(name, sizeof(name), "throw_depth_%d", d);
+        bench_run("flux", name, flux_throw_depth, &d, base, 1, threads);
+        bench_run("errno", name, errno_throw_depth, &d, base, 1, threads);
+    }
+
+    bench_run("flux", "throw_errno", flux_throw_errno, NULL, base, 1, threads);
+    bench_run("errno", "throw_errno", errno_throw_errno, NULL, base, 1, threads);
+
+    bench_run("flux", "defer", flux_defer, NULL, base / 4, DEFER_BATCH, threads);
+    bench_run("errno", "defer", errno_defer, NULL, base / 4, DEFER_BATCH, threads);
+    bench_run("flux", "scope_2_guards", flux_scope_small, NULL, base * 5, 1, threads);
+
+    bench_run("flux", "alloc_small_malloc", flux_malloc_small, NULL, base / 16, ALLOC_BATCH, threads);
+    bench_run("flux", "alloc_small_arena", flux_arena_small, NULL, base / 16, ALLOC_BATCH, threads);
+    bench_run("errno", "alloc_small_malloc", errno_malloc_small, NULL, base / 16, ALLOC_BATCH, threads);
+
+    bench_run("flux", "map_int_1k", flux_map_int_1k, NULL, base / 100 + 1, 2 * MAP_KEYS, threads);
+    bench_run("flux", "sb_line", flux_sb_line, NULL, base / 4, SB_FIELDS, threads);
+    bench_run("flux", "snprintf_line", flux_snprintf_line, NULL, base / 4, SB_FIELDS, threads);
+
+    for (size_t i = 0; i < sizeof(chains) / sizeof(chains[0]); i++) {
+        int n = chains[i];
+        long it = base * 4 / n + 1;
+        snprintf(name, sizeof(name), "release_%d", n);
+        bench_run("flux", name, flux_release, &n, it, n, threads);
+        bench_run("errno", name, errno_release, &n, it, n, threads);
+    }
+}
+
+int main(int argc, char** argv) {
+    int threads = bench_threads_from_args(argc, argv);
+    long base = bench_iters_from_env(200000);
+    run_all(1, base);
+    run_all(threads, base);
+    return 0;
+}
@@ -0,0 +1,17 @@
+#!/bin/sh
+# builds and runs the libflux benchmarks; usage: bench/run.sh [threads]
+# CC, CXX and CFLAGS may be overridden from the environment
+set -e
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+OUT=${BENCH_OUT:-/tmp/libflux-bench}
+CC=${CC:-cc}
+CXX=${CXX:-c++}
+CFLAGS=${CFLAGS:--O2}
+
+mkdir -p "$OUT"
+$CC $CFLAGS -I"$ROOT" "$ROOT/bench/flux_bench.c" -o "$OUT/flux_bench" -lpthread
+$CXX $CFLAGS "$ROOT/bench/cxx_bench.cpp" -o "$OUT/cxx_bench" -lpthread
+
+"$OUT/flux_bench" "$@"
+"$OUT/cxx_bench" "$@"
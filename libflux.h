@@ -6,50 +6,228 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdbool.h>
 #include <stdatomic.h>
 #include <errno.h>
+#if defined(__SSE2__)
+    #include <emmintrin.h>
+#endif
+
+#define __FLUX_CAT_(a, b) a##b
+#define __FLUX_CAT(a, b) __FLUX_CAT_(a, b)
 
 #if defined(_WIN32) || defined(_WIN64)
     #define FLUX_WINDOWS 1
     #include <windows.h>
+    #include <io.h>
 #else
     #define FLUX_POSIX 1
     #include <pthread.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
 #endif
 
-#define FLUX_MAX_DEPTH 64
-#define FLUX_POOL_SIZE 2048
+#if !defined(FLUX_USE_SETJMP) && defined(__ELF__) && !FLUX_WINDOWS && \
+    (defined(__x86_64__) || defined(__aarch64__))
+    #define FLUX_CTX_NATIVE 1
+#else
+    #define FLUX_CTX_NATIVE 0
+#endif
+
+/* default nesting limit, adjustable at run time with flux_set_max_depth() */
+#ifndef FLUX_MAX_DEPTH
+    #define FLUX_MAX_DEPTH 64
+#endif
+/* scopes per stack segment; the first segment is inline, the rest grow on demand */
+#ifndef FLUX_SCOPE_SEGMENT
+    #define FLUX_SCOPE_SEGMENT 8
+#endif
+/* guards held inline in each scope before it spills into the thread's pool */
+#ifndef FLUX_SCOPE_GUARDS
+    #define FLUX_SCOPE_GUARDS 4
+#endif
+/* guards held inline in each thread context; further slabs are heap-allocated on demand */
+#ifndef FLUX_POOL_SIZE
+    #define FLUX_POOL_SIZE 128
+#endif
+#ifndef FLUX_POOL_SLAB_SIZE
+    #define FLUX_POOL_SLAB_SIZE 1024
+#endif
+/* size of a FLUX_ARENA_ALLOC block; larger requests get a block of their own */
+#ifndef FLUX_ARENA_BLOCK_SIZE
+    #define FLUX_ARENA_BLOCK_SIZE (64 * 1024)
+#endif
+#define FLUX_ARENA_ALIGN _Alignof(max_align_t)
 #define FLUX_ERROR_MSG_MAX 512
+/* per-thread error slots; a throw from inside FLUX_CATCH takes the next one */
+#ifndef FLUX_ERROR_RING
+    #define FLUX_ERROR_RING 4
+#endif
+/* scalar arguments an error can carry for deferred formatting (FLUX_THROWF) */
+#define FLUX_ERROR_MAX_ARGS 4
 
 typedef struct flux_scope flux_scope_t;
+typedef struct flux_scope_seg flux_scope_seg_t;
 typedef struct flux_error flux_error_t;
+typedef struct flux_error_site flux_error_site_t;
 typedef struct flux_guard flux_guard_t;
+typedef struct flux_slab flux_slab_t;
+typedef struct flux_arena_block flux_arena_block_t;
 typedef struct flux_tls flux_tls_t;
 
+/* emitted once per FLUX_THROW call site; code and msg are filled in when they are constants */
+struct flux_error_site {
+    int32_t code;
+    const char* msg;
+    const char* file;
+    int line;
+};
+
+enum {
+    FLUX_ARG_INT,
+    FLUX_ARG_UINT,
+    FLUX_ARG_DOUBLE,
+    FLUX_ARG_PTR
+};
+
+typedef struct flux_error_arg {
+    int kind;
+    union {
+        intmax_t i;
+        uintmax_t u;
+        double d;
+        const void* p;
+    } v;
+} flux_error_arg_t;
+
+/*
+ * msg points at the site's literal or, for dynamic text, at buf. Errors
+ * thrown with a format or an errno keep the unformatted text in msg until
+ * flux_error_message() (or flux_error_print) renders the full text into buf.
+ */
 struct flux_error {
     int32_t code;
-    char msg[FLUX_ERROR_MSG_MAX];
-    char file[64];
+    const char* msg;
+    const char* file;
     int line;
+    const flux_error_site_t* site;
+    const char* fmt;
+    int sys_errno;
+    int nargs;
+    bool formatted;
+    flux_error_arg_t args[FLUX_ERROR_MAX_ARGS];
+    char buf[FLUX_ERROR_MSG_MAX];
 };
 
+/* what a guard releases; FLUX_GUARD_NONE marks a slot with nothing left to do */
+typedef enum flux_guard_kind {
+    FLUX_GUARD_NONE,
+    FLUX_GUARD_FREE,
+    FLUX_GUARD_FCLOSE,
+    FLUX_GUARD_CLOSE_FD,
+    FLUX_GUARD_MUNMAP,
+    FLUX_GUARD_ALIGNED_FREE,
+    FLUX_GUARD_CUSTOM,
+    FLUX_GUARD_TRANSFER = 0x100   /* or-ed into the kind: hand to the parent scope on exit */
+} flux_guard_kind_t;
+
 struct flux_guard {
-    void (*dtor)(void*);
-    void* ptr;
-    flux_guard_t* next;
+    union {
+        void* ptr;
+        int fd;
+    };
+    union {
+        void (*dtor)(void*);   /* FLUX_GUARD_CUSTOM */
+        size_t len;            /* FLUX_GUARD_MUNMAP */
+    };
+    int kind;
 };
 
-struct flux_scope {
+/* resume context of a FLUX_TRY: callee-saved registers, sp and return address */
+#if FLUX_CTX_NATIVE && defined(__x86_64__)
+typedef struct flux_ctx {
+    uintptr_t regs[9];   /* rbx rbp r12 r13 r14 r15 rsp rip ssp */
+} flux_ctx_t;
+#elif FLUX_CTX_NATIVE && defined(__aarch64__)
+typedef struct flux_ctx {
+    uintptr_t regs[21];  /* x19-x28 x29 x30 sp d8-d15 */
+} flux_ctx_t;
+#else
+typedef struct flux_ctx {
     jmp_buf buf;
-    flux_error_t err;
+} flux_ctx_t;
+#endif
+
+#if FLUX_CTX_NATIVE
+    extern int __flux_ctx_save(flux_ctx_t* ctx) __attribute__((returns_twice, visibility("hidden")));
+    extern void __flux_ctx_jump(flux_ctx_t* ctx, int val) __attribute__((noreturn, visibility("hidden")));
+    #define __FLUX_CTX_SAVE(ctx)      __flux_ctx_save(ctx)
+    #define __FLUX_CTX_JUMP(ctx, val) __flux_ctx_jump(ctx, val)
+#else
+    #define __FLUX_CTX_SAVE(ctx)      setjmp((ctx)->buf)
+    #define __FLUX_CTX_JUMP(ctx, val) longjmp((ctx)->buf, val)
+#endif
+
+struct flux_slab {
+    flux_slab_t* prev;
+    flux_slab_t* next;
     flux_guard_t* guards;
+    int cap;
+};
+
+typedef struct flux_pool_mark {
+    flux_slab_t* slab;
+    int idx;
+} flux_pool_mark_t;
+
+struct flux_arena_block {
+    flux_arena_block_t* prev;
+    flux_arena_block_t* next;
+    size_t cap;
+    _Alignas(max_align_t) char data[];
+};
+
+typedef struct flux_arena_mark {
+    flux_arena_block_t* block;
+    size_t off;
+} flux_arena_mark_t;
+
+/* bump allocator for FLUX_ARENA_ALLOC; blocks stay chained for reuse by later scopes */
+typedef struct flux_arena {
+    flux_arena_block_t* cur;
+    size_t off;
+    flux_arena_block_t* head;
+} flux_arena_t;
+
+struct flux_scope {
+    flux_ctx_t ctx;
+    flux_error_t* err;
+    flux_pool_mark_t pool_mark;
+    flux_arena_mark_t arena_mark;
+    flux_scope_t* parent;
+    flux_scope_seg_t* seg;
     bool active;
+    int nguards;
+    flux_guard_t guards[FLUX_SCOPE_GUARDS];
+};
+
+struct flux_scope_seg {
+    flux_scope_seg_t* prev;
+    flux_scope_seg_t* next;
+    flux_scope_t scopes[FLUX_SCOPE_SEGMENT];
 };
 
+/*
+ * Owned by one thread through flux_tls_t, so a plain bump index is enough.
+ * The first slab is inline; heap slabs are chained after it and kept for
+ * reuse once the scopes that needed them have exited.
+ */
 typedef struct flux_pool {
+    flux_slab_t* cur;
+    int idx;
+    flux_slab_t head;
     flux_guard_t guards[FLUX_POOL_SIZE];
-    atomic_int idx;
 } flux_pool_t;
 
 #if FLUX_WINDOWS
@@ -60,14 +238,38 @@ typedef struct flux_pool {
 
 static flux_tls_key_t __flux_tls_key;
 static atomic_bool __flux_initialized = false;
+static atomic_int __flux_default_max_depth = FLUX_MAX_DEPTH;
+
+/*
+ * POSIX fast path: the context pointer lives in a _Thread_local slot and the
+ * pthread key only runs __flux_tls_destructor at thread exit. Executables get
+ * local-exec from the compiler and shared objects keep its default model, so
+ * they still dlopen; a library that is always linked at startup can opt in
+ * with -DFLUX_TLS_MODEL='"initial-exec"'.
+ */
+#if FLUX_POSIX
+    #if defined(FLUX_TLS_MODEL)
+        #define __FLUX_TLS_ATTR __attribute__((tls_model(FLUX_TLS_MODEL)))
+    #else
+        #define __FLUX_TLS_ATTR
+    #endif
+    static _Thread_local flux_tls_t* __flux_tls_cur __FLUX_TLS_ATTR;
+#endif
 
 static inline void __flux_tls_destructor(void* ptr);
-static inline flux_tls_t* __flux_get_tls(void);
+static inline void __flux_tls_init(flux_tls_t* tls);
+static inline void __flux_tls_destroy(flux_tls_t* tls);
+static inline flux_tls_t* __flux_get_tls(void) __attribute__((returns_nonnull));
 
 struct flux_tls {
-    flux_scope_t stack[FLUX_MAX_DEPTH];
+    flux_scope_t* cur;
     int top;
+    int max_depth;
+    unsigned err_next;
     flux_pool_t pool;
+    flux_arena_t arena;
+    flux_scope_seg_t stack;
+    flux_error_t errs[FLUX_ERROR_RING];
 };
 
 static inline void __flux_init_once(void) {
@@ -89,198 +291,1862 @@ static inline void __flux_init_once(void) {
 
 static inline void __flux_tls_destructor(void* ptr) {
     if (ptr) {
+#if FLUX_POSIX
+        if (__flux_tls_cur == ptr) __flux_tls_cur = NULL;
+#endif
+        __flux_tls_destroy((flux_tls_t*)ptr);
         free(ptr);
     }
 }
 
+#if FLUX_POSIX
+__attribute__((noinline, cold, unused, returns_nonnull))
+static flux_tls_t* __flux_tls_create(void) {
+    __flux_init_once();
+    flux_tls_t* tls = (flux_tls_t*)calloc(1, sizeof(flux_tls_t));
+    if (!tls) abort();
+    __flux_tls_init(tls);
+    if (pthread_setspecific(__flux_tls_key, tls) != 0) abort();
+    __flux_tls_cur = tls;
+    return tls;
+}
+#endif
+
 static inline flux_tls_t* __flux_get_tls(void) {
+#if FLUX_POSIX
+    flux_tls_t* tls = __flux_tls_cur;
+    if (__builtin_expect(tls != NULL, 1)) return tls;
+    return __flux_tls_create();
+#else
     __flux_init_once();
-#if FLUX_WINDOWS
     flux_tls_t* tls = (flux_tls_t*)TlsGetValue(__flux_tls_key);
     if (GetLastError() != ERROR_SUCCESS) abort();
-#else
-    flux_tls_t* tls = (flux_tls_t*)pthread_getspecific(__flux_tls_key);
-#endif
     if (!tls) {
         tls = (flux_tls_t*)calloc(1, sizeof(flux_tls_t));
         if (!tls) abort();
-#if FLUX_WINDOWS
+        __flux_tls_init(tls);
         if (!TlsSetValue(__flux_tls_key, tls)) abort();
-#else
-        if (pthread_setspecific(__flux_tls_key, tls) != 0) abort();
-#endif
     }
     return tls;
+#endif
+}
+
+/*
+ * Thread context visible at the expansion site. FLUX_TRY declares a local
+ * __flux_cur_tls that shadows this NULL, so DEFER/MALLOC/THROW inside a TRY
+ * block reuse the context it already loaded; elsewhere the lookup runs.
+ */
+static flux_tls_t* const __flux_cur_tls __attribute__((unused)) = NULL;
+
+#define __FLUX_TLS() (__flux_cur_tls ? __flux_cur_tls : __flux_get_tls())
+
+static inline void __flux_pool_init(flux_pool_t* pool) {
+    pool->head.prev = NULL;
+    pool->head.next = NULL;
+    pool->head.guards = pool->guards;
+    pool->head.cap = FLUX_POOL_SIZE;
+    pool->cur = &pool->head;
+    pool->idx = 0;
+}
+
+static inline void __flux_pool_destroy(flux_pool_t* pool) {
+    flux_slab_t* slab = pool->head.next;
+    while (slab) {
+        flux_slab_t* next = slab->next;
+        free(slab);
+        slab = next;
+    }
+    pool->head.next = NULL;
+}
+
+__attribute__((noinline, cold, unused))
+static flux_guard_t* __flux_pool_grow(flux_pool_t* pool) {
+    flux_slab_t* next = pool->cur->next;
+    if (!next) {
+        next = (flux_slab_t*)malloc(sizeof(flux_slab_t) + FLUX_POOL_SLAB_SIZE * sizeof(flux_guard_t));
+        if (!next) return NULL;
+        next->prev = pool->cur;
+        next->next = NULL;
+        next->guards = (flux_guard_t*)(next + 1);
+        next->cap = FLUX_POOL_SLAB_SIZE;
+        pool->cur->next = next;
+    }
+    pool->cur = next;
+    pool->idx = 1;
+    return &next->guards[0];
 }
 
 static inline flux_guard_t* __flux_acquire_guard(flux_pool_t* pool) {
-    int idx = atomic_fetch_add(&pool->idx, 1);
-    if (idx >= FLUX_POOL_SIZE) {
-        atomic_fetch_sub(&pool->idx, 1);
-        return NULL;
+    int idx = pool->idx;
+    if (__builtin_expect(idx >= pool->cur->cap, 0)) return __flux_pool_grow(pool);
+    pool->idx = idx + 1;
+    return &pool->cur->guards[idx];
+}
+
+/* guards are allocated stack-wise: a scope hands back everything above its mark */
+static inline flux_pool_mark_t __flux_pool_mark(const flux_pool_t* pool) {
+    flux_pool_mark_t mark = { pool->cur, pool->idx };
+    return mark;
+}
+
+static inline void __flux_pool_restore(flux_pool_t* pool, flux_pool_mark_t mark) {
+    pool->cur = mark.slab;
+    pool->idx = mark.idx;
+}
+
+static inline void __flux_arena_destroy(flux_arena_t* arena) {
+    flux_arena_block_t* block = arena->head;
+    while (block) {
+        flux_arena_block_t* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->head = arena->cur = NULL;
+    arena->off = 0;
+}
+
+/*
+ * Moves to the next cached block that fits sz, or links a new one in after
+ * the current block. Returns NULL when the allocation fails.
+ */
+__attribute__((noinline, cold, unused))
+static void* __flux_arena_grow(flux_arena_t* arena, size_t sz) {
+    flux_arena_block_t* cur = arena->cur;
+    flux_arena_block_t* next = cur ? cur->next : arena->head;
+    if (!next || next->cap < sz) {
+        /* caps stay multiples of FLUX_ARENA_ALIGN so an aligned offset never passes the end */
+        size_t cap = ((size_t)FLUX_ARENA_BLOCK_SIZE + FLUX_ARENA_ALIGN - 1) & ~(size_t)(FLUX_ARENA_ALIGN - 1);
+        if (sz > cap) {
+            if (sz > SIZE_MAX - sizeof(flux_arena_block_t) - FLUX_ARENA_ALIGN) return NULL;
+            cap = (sz + FLUX_ARENA_ALIGN - 1) & ~(size_t)(FLUX_ARENA_ALIGN - 1);
+        }
+        flux_arena_block_t* block = (flux_arena_block_t*)malloc(sizeof(flux_arena_block_t) + cap);
+        if (!block) return NULL;
+        block->cap = cap;
+        block->prev = cur;
+        block->next = next;
+        if (next) next->prev = block;
+        if (cur) cur->next = block;
+        else arena->head = block;
+        next = block;
+    }
+    arena->cur = next;
+    arena->off = sz;
+    return next->data;
+}
+
+static inline void* __flux_arena_alloc(flux_arena_t* arena, size_t sz) {
+    flux_arena_block_t* block = arena->cur;
+    size_t off = (arena->off + FLUX_ARENA_ALIGN - 1) & ~(size_t)(FLUX_ARENA_ALIGN - 1);
+    if (__builtin_expect(block != NULL && sz <= block->cap - off, 1)) {
+        arena->off = off + sz;
+        return block->data + off;
+    }
+    return __flux_arena_grow(arena, sz);
+}
+
+/* over-allocates by align - 1 and hands the unused tail straight back */
+static inline void* __flux_arena_alloc_aligned(flux_arena_t* arena, size_t align, size_t sz) {
+    if (align <= FLUX_ARENA_ALIGN) return __flux_arena_alloc(arena, sz);
+    if (sz > SIZE_MAX - align) return NULL;
+    char* p = (char*)__flux_arena_alloc(arena, sz + align - 1);
+    if (!p) return NULL;
+    char* q = (char*)(((uintptr_t)p + align - 1) & ~(uintptr_t)(align - 1));
+    arena->off -= (size_t)(p + align - 1 - q);
+    return q;
+}
+
+static inline flux_arena_mark_t __flux_arena_mark(const flux_arena_t* arena) {
+    flux_arena_mark_t mark = { arena->cur, arena->off };
+    return mark;
+}
+
+static inline void __flux_arena_restore(flux_arena_t* arena, flux_arena_mark_t mark) {
+    arena->cur = mark.block;
+    arena->off = mark.off;
+}
+
+static inline void __flux_tls_init(flux_tls_t* tls) {
+    __flux_pool_init(&tls->pool);
+    tls->arena.cur = tls->arena.head = NULL;
+    tls->arena.off = 0;
+    tls->cur = NULL;
+    tls->top = 0;
+    tls->max_depth = atomic_load_explicit(&__flux_default_max_depth, memory_order_relaxed);
+}
+
+static inline void __flux_tls_destroy(flux_tls_t* tls) {
+    flux_scope_seg_t* seg = tls->stack.next;
+    while (seg) {
+        flux_scope_seg_t* next = seg->next;
+        free(seg);
+        seg = next;
+    }
+    tls->stack.next = NULL;
+    __flux_pool_destroy(&tls->pool);
+    __flux_arena_destroy(&tls->arena);
+}
+
+/* sets the nesting limit for the calling thread and for threads that start using libflux later */
+static inline void flux_set_max_depth(int depth) {
+    if (depth < 1) depth = 1;
+    atomic_store_explicit(&__flux_default_max_depth, depth, memory_order_relaxed);
+    __flux_get_tls()->max_depth = depth;
+}
+
+static inline int flux_max_depth(void) {
+    return __flux_get_tls()->max_depth;
+}
+
+__attribute__((noinline, cold, unused))
+static flux_scope_t* __flux_scope_grow(flux_scope_t* top) {
+    flux_scope_seg_t* seg = top->seg->next;
+    if (!seg) {
+        seg = (flux_scope_seg_t*)malloc(sizeof(flux_scope_seg_t));
+        if (!seg) return NULL;
+        seg->prev = top->seg;
+        seg->next = NULL;
+        top->seg->next = seg;
+    }
+    seg->scopes[0].seg = seg;
+    return &seg->scopes[0];
+}
+
+/* returns NULL when the depth limit is reached or a new segment cannot be allocated */
+static inline flux_scope_t* __flux_scope_push(flux_tls_t* tls) {
+    if (__builtin_expect(tls->top >= tls->max_depth, 0)) return NULL;
+    flux_scope_t* top = tls->cur;
+    flux_scope_t* s;
+    if (!top) {
+        s = &tls->stack.scopes[0];
+        s->seg = &tls->stack;
+    } else if (top != &top->seg->scopes[FLUX_SCOPE_SEGMENT - 1]) {
+        s = top + 1;
+        s->seg = top->seg;
+    } else {
+        s = __flux_scope_grow(top);
+        if (!s) return NULL;
+    }
+    s->parent = top;
+    s->pool_mark = __flux_pool_mark(&tls->pool);
+    s->arena_mark = __flux_arena_mark(&tls->arena);
+    s->active = true;
+    s->nguards = 0;
+    tls->cur = s;
+    tls->top++;
+    return s;
+}
+
+static inline void __flux_scope_pop(flux_tls_t* tls, flux_scope_t* s) {
+    __flux_pool_restore(&tls->pool, s->pool_mark);
+    __flux_arena_restore(&tls->arena, s->arena_mark);
+    s->active = false;
+    tls->cur = s->parent;
+    tls->top--;
+}
+
+static inline void __flux_close_fd(int fd) {
+#if FLUX_WINDOWS
+    _close(fd);
+#else
+    close(fd);
+#endif
+}
+
+/* blocks from here must go back through __flux_aligned_free (_aligned_free on Windows) */
+static inline void* __flux_aligned_alloc(size_t align, size_t sz) {
+#if FLUX_WINDOWS
+    return _aligned_malloc(sz, align);
+#else
+    void* p;
+    return posix_memalign(&p, align, sz) == 0 ? p : NULL;
+#endif
+}
+
+static inline void __flux_aligned_free(void* ptr) {
+#if FLUX_WINDOWS
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+static inline void __flux_munmap(void* ptr, size_t len) {
+#if FLUX_WINDOWS
+    (void)len;
+    UnmapViewOfFile(ptr);
+#else
+    munmap(ptr, len);
+#endif
+}
+
+/* guards ahead of the release cursor whose targets are prefetched */
+#define __FLUX_RELEASE_PREFETCH 4
+
+/*
+ * Releases [lo, hi) newest first. Runs of frees and fd closes are drained in
+ * their own loops, so the common cleanup is a direct call per guard with no
+ * dispatch between; the object a few guards further down is prefetched
+ * (free and fclose both touch it) while the current one is released.
+ */
+static inline int __flux_release_range(flux_guard_t* lo, flux_guard_t* hi) {
+    flux_guard_t* g = hi;
+    int moved = 0;
+    while (g > lo) {
+        g--;
+        if (g - lo >= __FLUX_RELEASE_PREFETCH) __builtin_prefetch(g[-__FLUX_RELEASE_PREFETCH].ptr);
+        switch (g->kind) {
+        case FLUX_GUARD_FREE:
+            for (;;) {
+                free(g->ptr);
+                if (g == lo || g[-1].kind != FLUX_GUARD_FREE) break;
+                g--;
+                if (g - lo >= __FLUX_RELEASE_PREFETCH) __builtin_prefetch(g[-__FLUX_RELEASE_PREFETCH].ptr);
+            }
+            break;
+        case FLUX_GUARD_CLOSE_FD:
+            for (;;) {
+                __flux_close_fd(g->fd);
+                if (g == lo || g[-1].kind != FLUX_GUARD_CLOSE_FD) break;
+                g--;
+            }
+            break;
+        case FLUX_GUARD_FCLOSE:
+            if (g->ptr) fclose((FILE*)g->ptr);
+            break;
+        case FLUX_GUARD_MUNMAP:
+            if (g->ptr) __flux_munmap(g->ptr, g->len);
+            break;
+        case FLUX_GUARD_ALIGNED_FREE:
+            __flux_aligned_free(g->ptr);
+            break;
+        case FLUX_GUARD_CUSTOM:
+            if (g->ptr) g->dtor(g->ptr);
+            break;
+        default:
+            if (g->kind & FLUX_GUARD_TRANSFER) moved++;
+            break;
+        }
+    }
+    return moved;
+}
+
+/*
+ * A scope's spilled guards are the pool entries between its mark and the pool
+ * top: scopes nested inside it have already handed theirs back. Walks that
+ * range backwards, slab by slab; every slab below the top one is full.
+ * Returns how many guards were left in place for transfer.
+ */
+static inline int __flux_release_guards(flux_pool_t* pool, flux_pool_mark_t mark) {
+    flux_slab_t* slab = pool->cur;
+    int idx = pool->idx;
+    int moved = 0;
+    for (;;) {
+        int lo = slab == mark.slab ? mark.idx : 0;
+        moved += __flux_release_range(slab->guards + lo, slab->guards + idx);
+        if (slab == mark.slab) break;
+        slab = slab->prev;
+        idx = slab->cap;
+    }
+    return moved;
+}
+
+/* most recently registered guard of scope s, which must be the innermost one */
+static inline flux_guard_t* __flux_last_guard(flux_tls_t* tls, flux_scope_t* s) {
+    flux_pool_t* pool = &tls->pool;
+    if (s->nguards < FLUX_SCOPE_GUARDS || (pool->cur == s->pool_mark.slab && pool->idx == s->pool_mark.idx))
+        return s->nguards ? &s->guards[s->nguards - 1] : NULL;
+    return pool->idx ? &pool->cur->guards[pool->idx - 1] : &pool->cur->prev->guards[pool->cur->prev->cap - 1];
+}
+
+/* g releases ptr with free(): a FREE guard, or FLUX_DEFER(free, ptr) */
+static inline bool __flux_guard_frees(const flux_guard_t* g, const void* ptr) {
+    int kind = g->kind & ~FLUX_GUARD_TRANSFER;
+    return g->ptr == ptr && (kind == FLUX_GUARD_FREE || (kind == FLUX_GUARD_CUSTOM && g->dtor == free));
+}
+
+/*
+ * Guard freeing ptr in the current scope or an enclosing one, or NULL.
+ * A buffer grown right after it was allocated is the innermost scope's last
+ * guard, so that one is tried before the scan.
+ */
+static inline flux_guard_t* __flux_find_guard(flux_tls_t* tls, const void* ptr) {
+    flux_pool_t* pool = &tls->pool;
+    if (!tls->cur) return NULL;
+    flux_guard_t* last = __flux_last_guard(tls, tls->cur);
+    if (last && __flux_guard_frees(last, ptr)) return last;
+    for (flux_scope_t* s = tls->cur; s; s = s->parent) {
+        for (int i = s->nguards - 1; i >= 0; i--) {
+            if (__flux_guard_frees(&s->guards[i], ptr)) return &s->guards[i];
+        }
+    }
+    for (flux_slab_t* slab = pool->cur; slab; slab = slab->prev) {
+        int idx = slab == pool->cur ? pool->idx : slab->cap;
+        for (flux_guard_t* g = slab->guards + idx; g > slab->guards; ) {
+            g--;
+            if (__flux_guard_frees(g, ptr)) return g;
+        }
+    }
+    return NULL;
+}
+
+/* the scope's inline slots first; the pool only once all of them are taken */
+static inline flux_guard_t* __flux_push_guard(flux_tls_t* tls, flux_scope_t* s) {
+    if (__builtin_expect(s->nguards < FLUX_SCOPE_GUARDS, 1)) return &s->guards[s->nguards++];
+    return __flux_acquire_guard(&tls->pool);
+}
+
+static inline flux_guard_t* __flux_pool_step(flux_pool_mark_t* c) {
+    if (c->idx == c->slab->cap) {
+        c->slab = c->slab->next;
+        c->idx = 0;
+    }
+    return &c->slab->guards[c->idx++];
+}
+
+/*
+ * Moves the guards flagged with FLUX_TRANSFER into the parent scope, oldest
+ * first so they keep their order. Copies that spill go above the pool top,
+ * beyond everything still being read, and are then slid down to the scope's
+ * mark; the mark is updated so the pop that follows keeps them.
+ */
+__attribute__((noinline, cold, unused))
+static void __flux_scope_transfer(flux_tls_t* tls, flux_scope_t* s) {
+    flux_pool_t* pool = &tls->pool;
+    flux_scope_t* parent = s->parent;
+    flux_pool_mark_t top = __flux_pool_mark(pool);
+    flux_pool_mark_t src = s->pool_mark;
+    int spilled = 0;
+    int n = s->nguards;
+    bool in_pool = false;
+    for (int i = 0;; i++) {
+        flux_guard_t* g;
+        if (i < n) {
+            g = &s->guards[i];
+        } else {
+            if (!in_pool && n < FLUX_SCOPE_GUARDS) break;
+            in_pool = true;
+            if (src.slab == top.slab && src.idx == top.idx) break;
+            g = __flux_pool_step(&src);
+        }
+        if (!(g->kind & FLUX_GUARD_TRANSFER)) continue;
+        if (!parent) continue;  /* leaving the outermost scope: the caller owns it now */
+        flux_guard_t moved = *g;
+        moved.kind &= ~FLUX_GUARD_TRANSFER;
+        flux_guard_t* d = __flux_push_guard(tls, parent);
+        if (!d) abort();
+        *d = moved;
+        if (d < parent->guards || d >= parent->guards + FLUX_SCOPE_GUARDS) spilled++;
+    }
+    flux_pool_mark_t dst = s->pool_mark;
+    while (spilled--) *__flux_pool_step(&dst) = *__flux_pool_step(&top);
+    s->pool_mark = dst;
+}
+
+/*
+ * Leaves a scope on either path: runs its guards, then hands back pool and
+ * arena space. Spilled guards are newer than the inline ones, so they go first.
+ */
+static inline void __flux_scope_exit(flux_tls_t* tls, flux_scope_t* s) {
+    if (s->nguards) {
+        flux_pool_t* pool = &tls->pool;
+        int moved = 0;
+        if (__builtin_expect(pool->idx != s->pool_mark.idx || pool->cur != s->pool_mark.slab, 0))
+            moved = __flux_release_guards(pool, s->pool_mark);
+        moved += __flux_release_range(s->guards, s->guards + s->nguards);
+        if (__builtin_expect(moved != 0, 0)) __flux_scope_transfer(tls, s);
+    }
+    __flux_scope_pop(tls, s);
+}
+
+static inline void __flux_error_from_site(flux_error_t* e, const flux_error_site_t* site) {
+    e->code = site->code;
+    e->msg = site->msg;
+    e->file = site->file;
+    e->line = site->line;
+    e->site = site;
+    e->fmt = NULL;
+    e->sys_errno = 0;
+    e->nargs = 0;
+    e->formatted = false;
+}
+
+static inline void __flux_error_copy_msg(flux_error_t* e, const char* msg) {
+    size_t n = msg ? strlen(msg) : 0;
+    if (n > FLUX_ERROR_MSG_MAX - 1) n = FLUX_ERROR_MSG_MAX - 1;
+    if (n) memcpy(e->buf, msg, n);
+    e->buf[n] = '\0';
+    e->msg = e->buf;
+}
+
+/* basename of the current file as a constant; __builtin_strrchr folds inside static initializers */
+#define __FLUX_BASENAME(path) \
+    (__builtin_strrchr(path, '/') ? __builtin_strrchr(path, '/') + 1 : \
+     __builtin_strrchr(path, '\\') ? __builtin_strrchr(path, '\\') + 1 : (path))
+
+#if defined(__FILE_NAME__)
+    #define FLUX_FILE_NAME __FILE_NAME__
+#else
+    #define FLUX_FILE_NAME __FLUX_BASENAME(__FILE__)
+#endif
+
+static inline flux_error_t* __flux_next_error(flux_tls_t* tls) {
+    return &tls->errs[tls->err_next++ % FLUX_ERROR_RING];
+}
+
+static inline flux_error_arg_t __flux_arg_i(intmax_t v) {
+    flux_error_arg_t a = { FLUX_ARG_INT, { .i = v } };
+    return a;
+}
+
+static inline flux_error_arg_t __flux_arg_u(uintmax_t v) {
+    flux_error_arg_t a = { FLUX_ARG_UINT, { .u = v } };
+    return a;
+}
+
+static inline flux_error_arg_t __flux_arg_d(double v) {
+    flux_error_arg_t a = { FLUX_ARG_DOUBLE, { .d = v } };
+    return a;
+}
+
+static inline flux_error_arg_t __flux_arg_p(const volatile void* v) {
+    flux_error_arg_t a = { FLUX_ARG_PTR, { .p = (const void*)v } };
+    return a;
+}
+
+/* end of the conversion spec at p (a '%'): *mod is where its length modifier starts */
+static inline const char* __flux_format_spec(const char* p, const char** mod) {
+    const char* q = p + 1;
+    while (*q && strchr("-+ #0", *q)) q++;
+    if (*q == '*') q++;
+    while (*q >= '0' && *q <= '9') q++;
+    if (*q == '.') {
+        q++;
+        if (*q == '*') q++;
+        while (*q >= '0' && *q <= '9') q++;
     }
-    return &pool->guards[idx];
+    *mod = q;
+    while (*q && strchr("hlLqjzt", *q)) q++;
+    return q;
 }
 
-static inline void __flux_reset_pool(flux_pool_t* pool) {
-    atomic_store(&pool->idx, 0);
+/* true when fmt has a %s conversion, whose argument may not outlive the throwing scope */
+static inline bool __flux_format_has_str(const char* fmt) {
+    for (const char* p = strchr(fmt, '%'); p; p = strchr(p, '%')) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        const char* mod;
+        const char* q = __flux_format_spec(p, &mod);
+        if (*q == 's') return true;
+        if (!*q) break;
+        p = q + 1;
+    }
+    return false;
+}
+
+static inline intmax_t __flux_arg_int(flux_error_arg_t a) {
+    return a.kind == FLUX_ARG_UINT ? (intmax_t)a.v.u :
+           a.kind == FLUX_ARG_DOUBLE ? (intmax_t)a.v.d :
+           a.kind == FLUX_ARG_PTR ? (intmax_t)(uintptr_t)a.v.p : a.v.i;
 }
 
-static inline void __flux_release_guards(flux_guard_t* head) {
-    while (head) {
-        if (head->dtor && head->ptr) {
-            head->dtor(head->ptr);
+/*
+ * Arguments are stored widened to intmax_t, so the conversion's length
+ * modifier (mod, up to q) picks the type printf would have read: %x of -1
+ * is ffffffff, %hhd of 300 is 44.
+ */
+static inline intmax_t __flux_narrow_signed(intmax_t v, const char* mod, const char* q) {
+    switch (q - mod) {
+    case 0: return (int)v;
+    case 1:
+        switch (*mod) {
+        case 'h': return (short)v;
+        case 'l': return (long)v;
+        case 'q': return (long long)v;
+        case 'z': case 't': return (ptrdiff_t)v;
+        default: return v;
         }
-        head = head->next;
+    default:
+        return mod[0] == 'h' ? (signed char)v : (long long)v;
     }
 }
 
-static inline flux_error_t __flux_make_error(int32_t code, const char* msg, const char* file, int line) {
-    flux_error_t e = {0};
-    e.code = code;
-    if (msg) {
-        strncpy(e.msg, msg, FLUX_ERROR_MSG_MAX - 1);
-        e.msg[FLUX_ERROR_MSG_MAX - 1] = '\0';
+static inline uintmax_t __flux_narrow_unsigned(intmax_t v, const char* mod, const char* q) {
+    switch (q - mod) {
+    case 0: return (unsigned)v;
+    case 1:
+        switch (*mod) {
+        case 'h': return (unsigned short)v;
+        case 'l': return (unsigned long)v;
+        case 'q': return (unsigned long long)v;
+        case 'z': case 't': return (size_t)v;
+        default: return (uintmax_t)v;
+        }
+    default:
+        return mod[0] == 'h' ? (unsigned char)v : (unsigned long long)v;
     }
-    if (file) {
-        const char* basename = strrchr(file, '/');
-        if (!basename) basename = strrchr(file, '\\');
-        basename = basename ? basename + 1 : file;
-        strncpy(e.file, basename, sizeof(e.file) - 1);
-        e.file[sizeof(e.file) - 1] = '\0';
+}
+
+/*
+ * Formats one conversion at a time, so each argument is passed with the type
+ * it was stored as. A '*' width or precision takes the next argument and is
+ * written into the spec as digits.
+ */
+__attribute__((noinline, cold, unused))
+static size_t __flux_format(char* out, size_t cap, const char* fmt,
+                                   const flux_error_arg_t* args, int nargs) {
+    size_t n = 0;
+    int ai = 0;
+    const char* p = fmt;
+    while (*p && n + 1 < cap) {
+        if (*p != '%') {
+            out[n++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[n++] = '%';
+            p += 2;
+            continue;
+        }
+        const char* mod;
+        const char* q = __flux_format_spec(p, &mod);
+        char conv = *q;
+        if (!conv) break;
+
+        char spec[48];
+        size_t sl = 0;
+        for (const char* c = p; c < mod && sl < sizeof(spec) - 24; c++) {
+            if (*c != '*') {
+                spec[sl++] = *c;
+                continue;
+            }
+            intmax_t v = __flux_arg_int(ai < nargs ? args[ai++] : __flux_arg_i(0));
+            if (c[-1] == '.') {
+                if (v < 0) sl--;   /* a negative precision is taken as omitted */
+                else sl += (size_t)snprintf(spec + sl, sizeof(spec) - sl, "%d", v > 9999 ? 9999 : (int)v);
+            } else {
+                if (v < 0) spec[sl++] = '-';   /* a negative width is the '-' flag */
+                uintmax_t w = v < 0 ? -(uintmax_t)v : (uintmax_t)v;
+                sl += (size_t)snprintf(spec + sl, sizeof(spec) - sl, "%d", w > 9999 ? 9999 : (int)w);
+            }
+        }
+        flux_error_arg_t a = ai < nargs ? args[ai++] : __flux_arg_i(0);
+        intmax_t iv = __flux_arg_int(a);
+        int w;
+        switch (conv) {
+        case 'd': case 'i':
+            spec[sl++] = 'j'; spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, __flux_narrow_signed(iv, mod, q));
+            break;
+        case 'u': case 'o': case 'x': case 'X':
+            spec[sl++] = 'j'; spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, __flux_narrow_unsigned(iv, mod, q));
+            break;
+        case 'c':
+            spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, (int)iv);
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, a.kind == FLUX_ARG_DOUBLE ? a.v.d : (double)iv);
+            break;
+        case 's':
+            spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, a.kind == FLUX_ARG_PTR && a.v.p ? (const char*)a.v.p : "(null)");
+            break;
+        case 'p':
+            spec[sl++] = conv; spec[sl] = '\0';
+            w = snprintf(out + n, cap - n, spec, a.kind == FLUX_ARG_PTR ? a.v.p : (const void*)(uintptr_t)iv);
+            break;
+        default:
+            w = 0;
+            break;
+        }
+        if (w < 0) break;
+        n += (size_t)w < cap - n ? (size_t)w : cap - n - 1;
+        p = q + 1;
     }
-    e.line = line;
-    return e;
+    out[n] = '\0';
+    return n;
+}
+
+static inline const char* __flux_strerror(int err, char* buf, size_t len) {
+#if FLUX_WINDOWS
+    strerror_s(buf, len, err);
+    return buf;
+#elif defined(__GLIBC__) && defined(_GNU_SOURCE)
+    return strerror_r(err, buf, len);
+#else
+    if (strerror_r(err, buf, len) != 0) snprintf(buf, len, "error %d", err);
+    return buf;
+#endif
+}
+
+/* full text of the error; deferred formats and errno strings are rendered on first call */
+static inline const char* flux_error_message(const flux_error_t* ce) {
+    if (!ce) return "";
+    flux_error_t* e = (flux_error_t*)ce; /* rendering only fills the slot's own buffer */
+    if (e->formatted || (!e->fmt && !e->sys_errno)) return e->msg ? e->msg : "";
+    size_t n;
+    if (e->fmt) {
+        n = __flux_format(e->buf, sizeof(e->buf), e->fmt, e->args, e->nargs);
+    } else if (e->msg != e->buf) {
+        __flux_error_copy_msg(e, e->msg);
+        n = strlen(e->buf);
+    } else {
+        n = strlen(e->buf);
+    }
+    if (e->sys_errno) {
+        char tmp[256];
+        const char* text = __flux_strerror(e->sys_errno, tmp, sizeof(tmp));
+        snprintf(e->buf + n, sizeof(e->buf) - n, "%s%s", n ? ": " : "", text);
+    }
+    e->msg = e->buf;
+    e->formatted = true;
+    return e->msg;
 }
 
 static inline void flux_error_print(const flux_error_t* e) {
-    if (e && e->msg[0]) {
-        fprintf(stderr, "🔥 [%s:%d] ERR %d: %s\n", e->file, e->line, (int)e->code, e->msg);
+    const char* msg = flux_error_message(e);
+    if (msg[0]) {
+        fprintf(stderr, "🔥 [%s:%d] ERR %d: %s\n", e->file, e->line, (int)e->code, msg);
     }
 }
 
-#define FLUX_THROW(code, msg) do { \
-    flux_tls_t* __tls = __flux_get_tls(); \
-    if (__tls->top >= 0 && __tls->top < FLUX_MAX_DEPTH) { \
-        __tls->stack[__tls->top].err = __flux_make_error(code, msg, __FILE__, __LINE__); \
-        longjmp(__tls->stack[__tls->top].buf, 1); \
-    } else { \
-        flux_error_t __e = __flux_make_error(code, msg, __FILE__, __LINE__); \
-        flux_error_print(&__e); \
-        abort(); \
-    } \
+__attribute__((noreturn))
+static inline void __flux_raise(flux_tls_t* tls, flux_error_t* e) {
+    if (tls->cur) {
+        tls->cur->err = e;
+        __FLUX_CTX_JUMP(&tls->cur->ctx, 1);
+    }
+    flux_error_print(e);
+    abort();
+}
+
+/*
+ * The site pointer is laundered through an empty asm so loads go to .rodata:
+ * GCC 12 can mis-fold reads of initializers that use __builtin_constant_p.
+ */
+#define __FLUX_ERROR_SITE(ecode, emsg) ({ \
+    static const flux_error_site_t __site = { \
+        __builtin_constant_p(ecode) ? (int32_t)(ecode) : 0, \
+        __builtin_constant_p(emsg) ? (emsg) : NULL, \
+        FLUX_FILE_NAME, __LINE__ \
+    }; \
+    const flux_error_site_t* __sp = &__site; \
+    __asm__("" : "+r"(__sp)); \
+    __sp; \
+})
+
+/* literal msgs are thrown by pointer to the static site; only dynamic text is copied */
+__attribute__((noinline, cold, noreturn, unused))
+static void __flux_throw(const flux_error_site_t* site, int32_t code, const char* msg) {
+    flux_tls_t* tls = __flux_get_tls();
+    flux_error_t* e = __flux_next_error(tls);
+    __flux_error_from_site(e, site);
+    e->code = code;
+    if (!e->msg) __flux_error_copy_msg(e, msg);
+    __flux_raise(tls, e);
+}
+
+__attribute__((noinline, cold, noreturn, unused))
+static void __flux_throw_errno(const flux_error_site_t* site, int err, const char* msg) {
+    flux_tls_t* tls = __flux_get_tls();
+    flux_error_t* e = __flux_next_error(tls);
+    __flux_error_from_site(e, site);
+    e->code = err;
+    e->sys_errno = err;
+    if (!e->msg) __flux_error_copy_msg(e, msg);
+    __flux_raise(tls, e);
+}
+
+/*
+ * Numbers stay in args until the message is read. A %s argument may be freed
+ * by the guards that run before FLUX_CATCH, so a format with one is rendered
+ * here, as is any format when render is set.
+ */
+__attribute__((noinline, cold, noreturn, unused))
+static void __flux_throw_fmt(const flux_error_site_t* site, int32_t code, const char* fmt,
+                             const flux_error_arg_t* args, int nargs, bool render) {
+    flux_tls_t* tls = __flux_get_tls();
+    flux_error_t* e = __flux_next_error(tls);
+    __flux_error_from_site(e, site);
+    e->code = code;
+    e->msg = fmt;
+    e->fmt = fmt;
+    e->nargs = nargs < FLUX_ERROR_MAX_ARGS ? nargs : FLUX_ERROR_MAX_ARGS;
+    memcpy(e->args, args, sizeof(flux_error_arg_t) * (size_t)e->nargs);
+    if (render || __flux_format_has_str(fmt)) flux_error_message(e);
+    __flux_raise(tls, e);
+}
+
+#define FLUX_THROW(ecode, emsg) __flux_throw(__FLUX_ERROR_SITE(ecode, emsg), (int32_t)(ecode), (emsg))
+
+/* records errno; "msg: strerror(errno)" is rendered only when the message is read */
+#define FLUX_THROW_ERRNO(emsg) do { \
+    int __flux_saved_errno = errno; \
+    __flux_throw_errno(__FLUX_ERROR_SITE(0, emsg), __flux_saved_errno, (emsg)); \
 } while(0)
 
-#define FLUX_THROW_ERRNO(msg) do { \
-    char __buf[FLUX_ERROR_MSG_MAX]; \
-    strerror_r(errno, __buf, sizeof(__buf)); \
-    char __full_msg[FLUX_ERROR_MSG_MAX]; \
-    snprintf(__full_msg, sizeof(__full_msg), "%s: %s", msg, __buf); \
-    FLUX_THROW(errno, __full_msg); \
+/* any pointer (class 5) is stored as one; only the chosen function is type-checked against x */
+#define __FLUX_ARG(x) __builtin_choose_expr(__builtin_classify_type(x) == 5, __flux_arg_p, \
+    _Generic((x), \
+    float: __flux_arg_d, double: __flux_arg_d, long double: __flux_arg_d, \
+    _Bool: __flux_arg_u, unsigned char: __flux_arg_u, unsigned short: __flux_arg_u, \
+    unsigned int: __flux_arg_u, unsigned long: __flux_arg_u, unsigned long long: __flux_arg_u, \
+    default: __flux_arg_i))(x)
+
+/* counts up to 16 arguments so that too many reach the _Static_assert instead of a paste error */
+#define __FLUX_NARGS(...) \
+    __FLUX_NARGS_(0, ##__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define __FLUX_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, n, ...) n
+#define __FLUX_ARGS_SEL(...) \
+    __FLUX_NARGS_(0, ##__VA_ARGS__, X, X, X, X, X, X, X, X, X, X, X, X, 4, 3, 2, 1, 0)
+#define __FLUX_ARGS_X(...)
+#define __FLUX_ARGS_0()
+#define __FLUX_ARGS_1(a) __FLUX_ARG(a),
+#define __FLUX_ARGS_2(a, ...) __FLUX_ARG(a), __FLUX_ARGS_1(__VA_ARGS__)
+#define __FLUX_ARGS_3(a, ...) __FLUX_ARG(a), __FLUX_ARGS_2(__VA_ARGS__)
+#define __FLUX_ARGS_4(a, ...) __FLUX_ARG(a), __FLUX_ARGS_3(__VA_ARGS__)
+
+#define __FLUX_THROWF(render, ecode, efmt, ...) do { \
+    _Static_assert(__FLUX_NARGS(__VA_ARGS__) <= FLUX_ERROR_MAX_ARGS, \
+                   "FLUX_THROWF takes at most FLUX_ERROR_MAX_ARGS (4) format arguments"); \
+    const flux_error_arg_t __args[FLUX_ERROR_MAX_ARGS + 1] = { \
+        __FLUX_CAT(__FLUX_ARGS_, __FLUX_ARGS_SEL(__VA_ARGS__))(__VA_ARGS__) \
+    }; \
+    __flux_throw_fmt(__FLUX_ERROR_SITE(ecode, "" efmt), (int32_t)(ecode), "" efmt, \
+                     __args, __FLUX_NARGS(__VA_ARGS__), render); \
 } while(0)
 
+/*
+ * Deferred-format throw: efmt must be a string literal and takes at most
+ * FLUX_ERROR_MAX_ARGS arguments, counting those for a '*' width or precision.
+ * Numeric arguments are formatted only when the message is read; a format
+ * with %s is rendered at the throw, while the strings are still alive.
+ */
+#define FLUX_THROWF(ecode, efmt, ...) __FLUX_THROWF(false, ecode, efmt, ##__VA_ARGS__)
+
+/* FLUX_THROWF that always renders the message at the throw */
+#define FLUX_THROWF_NOW(ecode, efmt, ...) __FLUX_THROWF(true, ecode, efmt, ##__VA_ARGS__)
+
 #define FLUX_THROW_FILE(msg)     FLUX_THROW(1, msg)
 #define FLUX_THROW_MEMORY()      FLUX_THROW(2, "out of memory")
 #define FLUX_THROW_PARSE(msg)    FLUX_THROW(3, msg)
 #define FLUX_THROW_INVALID(msg)  FLUX_THROW(4, msg)
 #define FLUX_THROW_LIMIT()       FLUX_THROW(5, "resource limit exceeded")
 
+/*
+ * __tls and __s are volatile so that -Wclobbered stays quiet in every
+ * function using FLUX_TRY; each is one stack slot read back at scope exit.
+ */
 #define FLUX_TRY \
     do { \
-        flux_tls_t* __tls = __flux_get_tls(); \
-        if (__tls->top + 1 >= FLUX_MAX_DEPTH) abort(); \
-        int __l = ++__tls->top; \
-        __tls->stack[__l].guards = NULL; \
-        __tls->stack[__l].active = true; \
-        __flux_reset_pool(&__tls->pool); \
-        if (setjmp(__tls->stack[__l].buf) == 0) {
+        flux_tls_t* volatile __tls = __FLUX_TLS(); \
+        flux_tls_t* const __flux_cur_tls = __tls; \
+        (void)__flux_cur_tls; \
+        flux_scope_t* volatile __s = __flux_scope_push(__flux_cur_tls); \
+        if (__builtin_expect(!__s, 0)) FLUX_THROW_LIMIT(); \
+        if (__FLUX_CTX_SAVE(&__s->ctx) == 0) {
 
 #define FLUX_CATCH(e) \
-            __tls->stack[__l].active = false; \
-            __tls->top--; \
+            __flux_scope_exit(__tls, __s); \
         } else { \
-            flux_error_t* e = &__tls->stack[__l].err; \
-            __flux_release_guards(__tls->stack[__l].guards); \
-            __tls->stack[__l].active = false; \
-            __tls->top--;
+            flux_error_t* e = __s->err; \
+            __flux_scope_exit(__tls, __s);
 
 #define FLUX_END_TRY \
         } \
     } while(0)
 
-#define FLUX_DEFER(dt, p) do { \
-    flux_tls_t* __tls = __flux_get_tls(); \
-    flux_guard_t* __g = __flux_acquire_guard(&__tls->pool); \
-    if (__g) { \
-        __g->dtor = (void(*)(void*))(dt); \
-        __g->ptr = (void*)(p); \
-        __g->next = __tls->stack[__tls->top].guards; \
-        __tls->stack[__tls->top].guards = __g; \
-    } else { \
-        FLUX_THROW_LIMIT(); \
+/* takes the next guard slot of the innermost scope; NULL outside any FLUX_TRY */
+#define __FLUX_GUARD_PUSH(gkind) ({ \
+    flux_tls_t* __gt = __FLUX_TLS(); \
+    flux_guard_t* __g = NULL; \
+    if (__gt->cur) { \
+        __g = __flux_push_guard(__gt, __gt->cur); \
+        if (__builtin_expect(!__g, 0)) FLUX_THROW_LIMIT(); \
+        __g->kind = (gkind); \
     } \
-} while(0)
+    __g; \
+})
+
+/*
+ * Registers dt(p) with the innermost FLUX_TRY. Guards run newest first when
+ * that scope exits, whether it completes or throws; outside any scope this
+ * is a no-op and yields NULL. dt must not throw.
+ *
+ * The result is a handle for FLUX_DISARM / FLUX_TRANSFER, valid until the
+ * scope exits.
+ */
+#define FLUX_DEFER(dt, p) ({ \
+    flux_guard_t* __dg = __FLUX_GUARD_PUSH(FLUX_GUARD_CUSTOM); \
+    if (__dg) { \
+        __dg->dtor = (void(*)(void*))(dt); \
+        __dg->ptr = (void*)(p); \
+    } \
+    __dg; \
+})
+
+/* typed guards: released without an indirect call */
+#define __FLUX_DEFER_PTR(gkind, p) ({ \
+    flux_guard_t* __dg = __FLUX_GUARD_PUSH(gkind); \
+    if (__dg) __dg->ptr = (void*)(p); \
+    __dg; \
+})
+
+#define FLUX_DEFER_FREE(p)   __FLUX_DEFER_PTR(FLUX_GUARD_FREE, p)
+#define FLUX_DEFER_FCLOSE(f) __FLUX_DEFER_PTR(FLUX_GUARD_FCLOSE, f)
+
+#define FLUX_DEFER_MUNMAP(p, sz) ({ \
+    flux_guard_t* __dg = __FLUX_GUARD_PUSH(FLUX_GUARD_MUNMAP); \
+    if (__dg) { \
+        __dg->ptr = (void*)(p); \
+        __dg->len = (sz); \
+    } \
+    __dg; \
+})
+
+/* the resource will not be released by the scope; the caller owns it again */
+static inline void flux_disarm(flux_guard_t* h) {
+    if (h) h->kind = FLUX_GUARD_NONE;
+}
 
-#define FLUX_MALLOC(sz) ({ \
+/*
+ * On exit of the guard's scope, success or throw, the guard moves to the
+ * enclosing scope instead of running. Leaving the outermost scope disarms it.
+ */
+static inline void flux_transfer(flux_guard_t* h) {
+    if (h && h->kind != FLUX_GUARD_NONE) h->kind |= FLUX_GUARD_TRANSFER;
+}
+
+#define FLUX_DISARM(h)   flux_disarm(h)
+#define FLUX_TRANSFER(h) flux_transfer(h)
+
+/*
+ * The _H forms of the allocating macros also store the new guard in the
+ * flux_guard_t* lvalue h (NULL outside FLUX_TRY), so the block can be
+ * returned with FLUX_DISARM(h) or moved out with FLUX_TRANSFER(h).
+ */
+#define __FLUX_NO_HANDLE(alloc_h, ...) ({ \
+    flux_guard_t* __mh __attribute__((unused)); \
+    alloc_h(__VA_ARGS__, __mh); \
+})
+
+#define FLUX_MALLOC_H(sz, h) ({ \
     size_t __sz = (sz); \
     if (__sz == 0) __sz = 1; \
     void* __p = malloc(__sz); \
-    if (!__p) FLUX_THROW_MEMORY(); \
-    FLUX_DEFER(free, __p); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    (h) = FLUX_DEFER_FREE(__p); \
     __p; \
 })
 
-#define FLUX_CALLOC(nmemb, sz) ({ \
+#define FLUX_CALLOC_H(nmemb, sz, h) ({ \
     size_t __nmemb = (nmemb); \
     size_t __sz = (sz); \
     if (__nmemb == 0 || __sz == 0) __nmemb = __sz = 1; \
     void* __p = calloc(__nmemb, __sz); \
-    if (!__p) FLUX_THROW_MEMORY(); \
-    FLUX_DEFER(free, __p); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    (h) = FLUX_DEFER_FREE(__p); \
     __p; \
 })
 
-#define FLUX_REALLOC(ptr, new_sz) ({ \
-    void* __old = (ptr); \
+#define FLUX_MALLOC(sz) __FLUX_NO_HANDLE(FLUX_MALLOC_H, sz)
+#define FLUX_CALLOC(nmemb, sz) __FLUX_NO_HANDLE(FLUX_CALLOC_H, nmemb, sz)
+
+/*
+ * A pointer already guarded by free() (FLUX_MALLOC and friends, or
+ * FLUX_DEFER(free, p)) has its guard moved to the new block instead of
+ * gaining a second one; other guards are not looked at. Keep a handle and
+ * use FLUX_REALLOC_GUARD to skip the lookup.
+ */
+#define FLUX_REALLOC(optr, new_sz) ({ \
+    void* __old = (optr); \
     size_t __sz = (new_sz); \
     if (__sz == 0) __sz = 1; \
+    flux_guard_t* __og = __old ? __flux_find_guard(__FLUX_TLS(), __old) : NULL; \
     void* __p = realloc(__old, __sz); \
-    if (!__p) FLUX_THROW_MEMORY(); \
-    FLUX_DEFER(free, __p); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    if (__og) __og->ptr = __p; \
+    else FLUX_DEFER_FREE(__p); \
     __p; \
 })
 
-#define FLUX_STRDUP(s) ({ \
+/*
+ * Grows the block owned by free guard h in place of the guard, O(1) with no
+ * lookup. A NULL h allocates a new block and stores its guard in h, so
+ *     flux_guard_t* h = NULL;
+ *     buf = FLUX_REALLOC_GUARD(h, cap *= 2);
+ * keeps one guard however often buf grows. Only valid inside FLUX_TRY.
+ */
+#define FLUX_REALLOC_GUARD(h, new_sz) ({ \
+    size_t __sz = (new_sz); \
+    if (__sz == 0) __sz = 1; \
+    flux_guard_t* __h = (h); \
+    void* __p = realloc(__h ? __h->ptr : NULL, __sz); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    if (__h) { \
+        __h->ptr = __p; \
+    } else { \
+        __h = FLUX_DEFER_FREE(__p); \
+        if (__builtin_expect(!__h, 0)) { \
+            free(__p); \
+            FLUX_THROW_INVALID("FLUX_REALLOC_GUARD outside FLUX_TRY"); \
+        } \
+        (h) = __h; \
+    } \
+    __p; \
+})
+
+#define FLUX_STRDUP_H(s, h) ({ \
     const char* __s = (s); \
     char* __p = __s ? strdup(__s) : NULL; \
-    if (!__p && __s) FLUX_THROW_MEMORY(); \
-    if (__p) FLUX_DEFER(free, __p); \
+    if (__builtin_expect(!__p && __s, 0)) FLUX_THROW_MEMORY(); \
+    (h) = __p ? FLUX_DEFER_FREE(__p) : NULL; \
     __p; \
 })
 
-#define FLUX_FOPEN(path, mode) ({ \
+#define FLUX_FOPEN_H(path, mode, h) ({ \
     const char* __path = (path); \
     const char* __mode = (mode); \
     FILE* __f = fopen(__path, __mode); \
-    if (!__f) { \
-        char __msg[256]; \
-        snprintf(__msg, sizeof(__msg), "fopen('%s', '%s') failed", __path, __mode); \
-        FLUX_THROW_FILE(__msg); \
-    } \
-    FLUX_DEFER(fclose, __f); \
+    if (__builtin_expect(!__f, 0)) \
+        FLUX_THROWF_NOW(1, "fopen('%s', '%s') failed", __path, __mode); \
+    (h) = FLUX_DEFER_FCLOSE(__f); \
     __f; \
 })
 
-#define FLUX_CLOSE_FD(fd) do { \
-    int __fd = (fd); \
+#define FLUX_STRDUP(s) __FLUX_NO_HANDLE(FLUX_STRDUP_H, s)
+#define FLUX_FOPEN(path, mode) __FLUX_NO_HANDLE(FLUX_FOPEN_H, path, mode)
+
+/*
+ * Bump allocation from the thread's arena, aligned for any type. No guard is
+ * registered: everything allocated inside a FLUX_TRY is released at once when
+ * that scope exits, on success or throw, so it is already gone in FLUX_CATCH.
+ */
+#define FLUX_ARENA_ALLOC(sz) ({ \
+    flux_tls_t* __tls = __FLUX_TLS(); \
+    if (__builtin_expect(!__tls->cur, 0)) FLUX_THROW_INVALID("FLUX_ARENA_ALLOC outside FLUX_TRY"); \
+    void* __p = __flux_arena_alloc(&__tls->arena, (sz)); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    __p; \
+})
+
+#define FLUX_CLOSE_FD(fdesc) do { \
+    int __fd = (fdesc); \
     if (__fd >= 0) { \
-        FLUX_DEFER(close, (void*)(intptr_t)__fd); \
+        flux_guard_t* __dg = __FLUX_GUARD_PUSH(FLUX_GUARD_CLOSE_FD); \
+        if (__dg) __dg->fd = __fd; \
     } \
 } while(0)
 
-#if FLUX_POSIX
-    #include <unistd.h>
-    #define close close
+/* for blocks from FLUX_ALIGNED_ALLOC / FLUX_ALIGNED_CALLOC that were disarmed */
+static inline void flux_aligned_free(void* ptr) {
+    __flux_aligned_free(ptr);
+}
+
+#define __FLUX_ALIGN_ARG(align) ({ \
+    size_t __a = (align); \
+    if (__builtin_expect(__a == 0 || (__a & (__a - 1)) != 0, 0)) \
+        FLUX_THROW_INVALID("alignment must be a power of two"); \
+    __a < sizeof(void*) ? sizeof(void*) : __a; \
+})
+
+/*
+ * Heap block aligned to align (a power of two), released by the enclosing
+ * scope like FLUX_MALLOC. A disarmed block is freed with flux_aligned_free.
+ */
+#define FLUX_ALIGNED_ALLOC_H(align, sz, h) ({ \
+    size_t __al = __FLUX_ALIGN_ARG(align); \
+    size_t __sz = (sz); \
+    if (__sz == 0) __sz = 1; \
+    void* __p = __flux_aligned_alloc(__al, __sz); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    (h) = __FLUX_DEFER_PTR(FLUX_GUARD_ALIGNED_FREE, __p); \
+    __p; \
+})
+
+#define FLUX_ALIGNED_CALLOC_H(align, nmemb, sz, h) ({ \
+    size_t __al = __FLUX_ALIGN_ARG(align); \
+    size_t __nmemb = (nmemb); \
+    size_t __sz = (sz); \
+    if (__nmemb == 0 || __sz == 0) __nmemb = __sz = 1; \
+    if (__builtin_expect(__nmemb > SIZE_MAX / __sz, 0)) FLUX_THROW_MEMORY(); \
+    void* __p = __flux_aligned_alloc(__al, __nmemb * __sz); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    memset(__p, 0, __nmemb * __sz); \
+    (h) = __FLUX_DEFER_PTR(FLUX_GUARD_ALIGNED_FREE, __p); \
+    __p; \
+})
+
+#define FLUX_ALIGNED_ALLOC(align, sz) __FLUX_NO_HANDLE(FLUX_ALIGNED_ALLOC_H, align, sz)
+#define FLUX_ALIGNED_CALLOC(align, nmemb, sz) __FLUX_NO_HANDLE(FLUX_ALIGNED_CALLOC_H, align, nmemb, sz)
+
+/* scratch from the scope arena at any power-of-two alignment; see FLUX_ARENA_ALLOC */
+#define FLUX_ARENA_ALLOC_ALIGNED(align, sz) ({ \
+    size_t __al = __FLUX_ALIGN_ARG(align); \
+    flux_tls_t* __tls = __FLUX_TLS(); \
+    if (__builtin_expect(!__tls->cur, 0)) FLUX_THROW_INVALID("FLUX_ARENA_ALLOC_ALIGNED outside FLUX_TRY"); \
+    void* __p = __flux_arena_alloc_aligned(&__tls->arena, __al, (sz)); \
+    if (__builtin_expect(!__p, 0)) FLUX_THROW_MEMORY(); \
+    __p; \
+})
+
+/* storage alignment of flux_vec types: a cache line, enough for any SIMD load */
+#define FLUX_VEC_ALIGN 64
+
+/* moves the aligned block owned by g to a larger one; g follows it, so no new guard is taken */
+__attribute__((noinline, cold, unused))
+static void* __flux_vec_grow(flux_guard_t* g, size_t used, size_t bytes) {
+    void* p = __flux_aligned_alloc(FLUX_VEC_ALIGN, bytes);
+    if (!p) FLUX_THROW_MEMORY();
+    if (used) memcpy(p, g->ptr, used);
+    __flux_aligned_free(g->ptr);
+    g->ptr = p;
+    return p;
+}
+
+/*
+ * Typed growable array owned by the FLUX_TRY scope that called name_init.
+ * The storage is FLUX_VEC_ALIGN-aligned and held by a single guard, which
+ * each growth updates in place, so push/reserve/extend never touch the guard
+ * pool. The vector must not be used after its scope exits; FLUX_TRANSFER or
+ * FLUX_DISARM on v->guard move or hand back the storage.
+ *
+ *     FLUX_VEC_DEFINE(int_vec, int)
+ *     int_vec v;
+ *     int_vec_init(&v, 0);
+ *     int_vec_push(&v, 42);
+ */
+#define FLUX_VEC_DEFINE(name, T) \
+typedef struct name { \
+    T* data; \
+    size_t len; \
+    size_t cap; \
+    flux_guard_t* guard; \
+} name; \
+\
+__attribute__((unused)) static inline void name##_reserve(name* v, size_t n) { \
+    if (__builtin_expect(n <= v->cap, 1)) return; \
+    size_t cap = v->cap > SIZE_MAX / 2 ? n : v->cap * 2; \
+    size_t min_cap = sizeof(T) < FLUX_VEC_ALIGN ? FLUX_VEC_ALIGN / sizeof(T) : 1; \
+    if (cap < min_cap) cap = min_cap; \
+    if (cap < n) cap = n; \
+    if (cap > SIZE_MAX / sizeof(T)) FLUX_THROW_LIMIT(); \
+    v->data = (T*)__flux_vec_grow(v->guard, v->len * sizeof(T), cap * sizeof(T)); \
+    v->cap = cap; \
+} \
+\
+__attribute__((unused)) static inline void name##_init(name* v, size_t cap) { \
+    v->data = NULL; \
+    v->len = 0; \
+    v->cap = 0; \
+    v->guard = __FLUX_DEFER_PTR(FLUX_GUARD_ALIGNED_FREE, NULL); \
+    if (!v->guard) FLUX_THROW_INVALID(#name "_init outside FLUX_TRY"); \
+    if (cap) name##_reserve(v, cap); \
+} \
+\
+__attribute__((unused)) static inline void name##_push(name* v, T x) { \
+    if (__builtin_expect(v->len == v->cap, 0)) name##_reserve(v, v->len + 1); \
+    v->data[v->len++] = x; \
+} \
+\
+__attribute__((unused)) static inline void name##_extend(name* v, const T* src, size_t n) { \
+    if (n > SIZE_MAX - v->len) FLUX_THROW_LIMIT(); \
+    /* src may point into data, which growing frees */ \
+    uintptr_t off = (uintptr_t)src - (uintptr_t)v->data; \
+    bool self = v->data && off < v->len * sizeof(T); \
+    name##_reserve(v, v->len + n); \
+    if (self) src = (const T*)((const char*)v->data + off); \
+    if (n) memcpy(v->data + v->len, src, n * sizeof(T)); \
+    v->len += n; \
+}
+
+/*
+ * Open-addressing hash map on the scope arena, keyed by strings or by 64-bit
+ * integers, with void* values. Slots are probed 16 at a time through a
+ * control byte per slot: EMPTY, or the low 7 bits of the key's hash.
+ *
+ * The table, its growth and copies of string keys come from the arena of the
+ * scope that created the map, so everything disappears with that scope and
+ * nothing is freed one by one. Lookups work from nested scopes too; inserts
+ * that allocate throw FLUX_THROW_INVALID there, since a nested scope would
+ * hand the memory back when it exits. There is no removal.
+ */
+#define __FLUX_MAP_GROUP 16
+#define __FLUX_MAP_EMPTY 0x80
+
+typedef struct flux_map_slot {
+    uint64_t hash;
+    union {
+        uint64_t i;
+        const char* s;
+    } key;
+    size_t klen;
+    void* value;
+} flux_map_slot_t;
+
+typedef struct flux_map {
+    uint8_t* ctrl;
+    flux_map_slot_t* slots;
+    size_t cap;           /* power of two, at least one group */
+    size_t len;
+    bool str_keys;
+    flux_scope_t* owner;
+} flux_map_t;
+
+static inline uint64_t __flux_hash_u64(uint64_t x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+static inline uint64_t __flux_hash_bytes(const void* key, size_t n) {
+    const unsigned char* p = (const unsigned char*)key;
+    uint64_t h = 0x9e3779b97f4a7c15ULL ^ n;
+    uint64_t w;
+    for (; n >= 8; p += 8, n -= 8) {
+        memcpy(&w, p, 8);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+    }
+    w = 0;
+    memcpy(&w, p, n);
+    return __flux_hash_u64(h ^ w);
+}
+
+#if !defined(__SSE2__)
+#define __FLUX_BYTES_LO 0x0101010101010101ULL
+#define __FLUX_BYTES_HI 0x8080808080808080ULL
+
+/* gathers the top bit of each byte of w into an 8-bit mask, byte 0 in bit 0 */
+static inline unsigned __flux_swar_movemask(uint64_t w) {
+    uint64_t t = (w & __FLUX_BYTES_HI) >> 7;
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    t = __builtin_bswap64(t);
+#endif
+    return (unsigned)((t * 0x0102040810204080ULL) >> 56);
+}
+
+/* top bit set in exactly the zero bytes of x, with no borrow into neighbours */
+static inline uint64_t __flux_swar_zero(uint64_t x) {
+    return ~(((x & ~__FLUX_BYTES_HI) + ~__FLUX_BYTES_HI) | x) & __FLUX_BYTES_HI;
+}
+#endif
+
+/* bit i set when control byte i of the group equals h2 / is EMPTY; SWAR on two words without SSE2 */
+static inline unsigned __flux_group_match(const uint8_t* ctrl, uint8_t h2) {
+#if defined(__SSE2__)
+    __m128i g = _mm_load_si128((const __m128i*)ctrl);
+    return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8((char)h2)));
+#else
+    uint64_t lo, hi, pat = __FLUX_BYTES_LO * h2;
+    memcpy(&lo, ctrl, 8);
+    memcpy(&hi, ctrl + 8, 8);
+    return __flux_swar_movemask(__flux_swar_zero(lo ^ pat)) |
+           __flux_swar_movemask(__flux_swar_zero(hi ^ pat)) << 8;
+#endif
+}
+
+static inline unsigned __flux_group_empty(const uint8_t* ctrl) {
+#if defined(__SSE2__)
+    return (unsigned)_mm_movemask_epi8(_mm_load_si128((const __m128i*)ctrl));
+#else
+    uint64_t lo, hi;
+    memcpy(&lo, ctrl, 8);
+    memcpy(&hi, ctrl + 8, 8);
+    return __flux_swar_movemask(lo) | __flux_swar_movemask(hi) << 8;
+#endif
+}
+
+static inline void* __flux_map_alloc(flux_map_t* m, size_t sz) {
+    flux_tls_t* tls = __flux_get_tls();
+    if (tls->cur != m->owner) FLUX_THROW_INVALID("flux_map grown outside the scope that created it");
+    void* p = __flux_arena_alloc_aligned(&tls->arena, __FLUX_MAP_GROUP, sz);
+    if (!p) FLUX_THROW_MEMORY();
+    return p;
+}
+
+static inline void __flux_map_alloc_table(flux_map_t* m, size_t cap) {
+    if (cap > SIZE_MAX / (sizeof(flux_map_slot_t) + 1)) FLUX_THROW_LIMIT();
+    m->ctrl = (uint8_t*)__flux_map_alloc(m, cap + cap * sizeof(flux_map_slot_t));
+    m->slots = (flux_map_slot_t*)(m->ctrl + cap);
+    m->cap = cap;
+    memset(m->ctrl, __FLUX_MAP_EMPTY, cap);
+}
+
+/*
+ * Groups are visited in triangular steps, which reaches every group of a
+ * power-of-two table. Without removal, a group holding an EMPTY byte ends
+ * the probe: an insert would have used it.
+ */
+#define __FLUX_MAP_PROBE(m, hash, slot, found) do { \
+    size_t __mask = (m)->cap - 1; \
+    size_t __pos = (size_t)((hash) >> 7) & __mask & ~(size_t)(__FLUX_MAP_GROUP - 1); \
+    uint8_t __h2 = (uint8_t)((hash) & 0x7f); \
+    for (size_t __step = __FLUX_MAP_GROUP;; __step += __FLUX_MAP_GROUP) { \
+        const uint8_t* __grp = (m)->ctrl + __pos; \
+        for (unsigned __bits = __flux_group_match(__grp, __h2); __bits; __bits &= __bits - 1) { \
+            flux_map_slot_t* slot = &(m)->slots[__pos + (size_t)__builtin_ctz(__bits)]; \
+            if (slot->hash == (hash) && (found)) return slot; \
+        } \
+        if (__builtin_expect(__flux_group_empty(__grp) != 0, 1)) return NULL; \
+        __pos = (__pos + __step) & __mask; \
+    } \
+} while(0)
+
+static inline flux_map_slot_t* __flux_map_lookup_str(const flux_map_t* m, uint64_t hash,
+                                                     const char* key, size_t klen) {
+    __FLUX_MAP_PROBE(m, hash, slot, slot->klen == klen && memcmp(slot->key.s, key, klen) == 0);
+}
+
+static inline flux_map_slot_t* __flux_map_lookup_int(const flux_map_t* m, uint64_t hash, uint64_t key) {
+    __FLUX_MAP_PROBE(m, hash, slot, slot->key.i == key);
+}
+
+static inline flux_map_slot_t* __flux_map_claim(flux_map_t* m, uint64_t hash) {
+    size_t mask = m->cap - 1;
+    size_t pos = (size_t)(hash >> 7) & mask & ~(size_t)(__FLUX_MAP_GROUP - 1);
+    for (size_t step = __FLUX_MAP_GROUP;; step += __FLUX_MAP_GROUP) {
+        unsigned empty = __flux_group_empty(m->ctrl + pos);
+        if (__builtin_expect(empty != 0, 1)) {
+            size_t i = pos + (size_t)__builtin_ctz(empty);
+            m->ctrl[i] = (uint8_t)(hash & 0x7f);
+            m->slots[i].hash = hash;
+            return &m->slots[i];
+        }
+        pos = (pos + step) & mask;
+    }
+}
+
+/* doubles the table; the old one stays in the arena until the scope exits */
+__attribute__((noinline, cold, unused))
+static void __flux_map_grow(flux_map_t* m) {
+    uint8_t* old_ctrl = m->ctrl;
+    flux_map_slot_t* old_slots = m->slots;
+    size_t old_cap = m->cap;
+    if (old_cap > SIZE_MAX / 2) FLUX_THROW_LIMIT();
+    __flux_map_alloc_table(m, old_cap * 2);
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old_ctrl[i] & __FLUX_MAP_EMPTY) continue;
+        *__flux_map_claim(m, old_slots[i].hash) = old_slots[i];
+    }
+}
+
+/* a new map owned by the current FLUX_TRY, sized for hint entries without growing */
+static inline flux_map_t* __flux_map_new(bool str_keys, size_t hint) {
+    flux_tls_t* tls = __flux_get_tls();
+    if (!tls->cur) FLUX_THROW_INVALID("flux_map created outside FLUX_TRY");
+    flux_map_t* m = (flux_map_t*)__flux_arena_alloc(&tls->arena, sizeof(flux_map_t));
+    if (!m) FLUX_THROW_MEMORY();
+    m->len = 0;
+    m->str_keys = str_keys;
+    m->owner = tls->cur;
+    size_t cap = __FLUX_MAP_GROUP;
+    while (cap - cap / 8 < hint) {
+        if (cap > SIZE_MAX / 4) FLUX_THROW_LIMIT();
+        cap *= 2;
+    }
+    __flux_map_alloc_table(m, cap);
+    return m;
+}
+
+static inline flux_map_t* flux_map_new_str(size_t hint) {
+    return __flux_map_new(true, hint);
+}
+
+static inline flux_map_t* flux_map_new_int(size_t hint) {
+    return __flux_map_new(false, hint);
+}
+
+static inline size_t flux_map_len(const flux_map_t* m) {
+    return m->len;
+}
+
+/* string and integer keys share the slot's key union, so a map only takes the kind it was created for */
+#define __FLUX_MAP_KEYS(m, str) do { \
+    if (__builtin_expect((m)->str_keys != (str), 0)) \
+        FLUX_THROW_INVALID((str) ? "string key used on an integer-keyed flux_map" \
+                                 : "integer key used on a string-keyed flux_map"); \
+} while(0)
+
+/* address of the value stored under key, or NULL; the value can be updated through it */
+static inline void** flux_map_find_strn(const flux_map_t* m, const char* key, size_t klen) {
+    __FLUX_MAP_KEYS(m, true);
+    flux_map_slot_t* slot = __flux_map_lookup_str(m, __flux_hash_bytes(key, klen), key, klen);
+    return slot ? &slot->value : NULL;
+}
+
+static inline void** flux_map_find_str(const flux_map_t* m, const char* key) {
+    return flux_map_find_strn(m, key, strlen(key));
+}
+
+static inline void** flux_map_find_int(const flux_map_t* m, uint64_t key) {
+    __FLUX_MAP_KEYS(m, false);
+    flux_map_slot_t* slot = __flux_map_lookup_int(m, __flux_hash_u64(key), key);
+    return slot ? &slot->value : NULL;
+}
+
+/* inserts or overwrites; a new key is copied into the arena, NUL-terminated */
+static inline void flux_map_put_strn(flux_map_t* m, const char* key, size_t klen, void* value) {
+    __FLUX_MAP_KEYS(m, true);
+    uint64_t hash = __flux_hash_bytes(key, klen);
+    flux_map_slot_t* slot = __flux_map_lookup_str(m, hash, key, klen);
+    if (!slot) {
+        if (klen == SIZE_MAX) FLUX_THROW_LIMIT();
+        char* copy = (char*)__flux_map_alloc(m, klen + 1);
+        memcpy(copy, key, klen);
+        copy[klen] = '\0';
+        if (__builtin_expect(m->len + 1 > m->cap - m->cap / 8, 0)) __flux_map_grow(m);
+        slot = __flux_map_claim(m, hash);
+        slot->key.s = copy;
+        slot->klen = klen;
+        m->len++;
+    }
+    slot->value = value;
+}
+
+static inline void flux_map_put_str(flux_map_t* m, const char* key, void* value) {
+    flux_map_put_strn(m, key, strlen(key), value);
+}
+
+static inline void flux_map_put_int(flux_map_t* m, uint64_t key, void* value) {
+    __FLUX_MAP_KEYS(m, false);
+    uint64_t hash = __flux_hash_u64(key);
+    flux_map_slot_t* slot = __flux_map_lookup_int(m, hash, key);
+    if (!slot) {
+        if (__builtin_expect(m->len + 1 > m->cap - m->cap / 8, 0)) __flux_map_grow(m);
+        slot = __flux_map_claim(m, hash);
+        slot->key.i = key;
+        slot->klen = sizeof(key);
+        m->len++;
+    }
+    slot->value = value;
+}
+
+/*
+ * Growable string owned by the FLUX_TRY scope that called flux_sb_init. One
+ * FREE guard holds the buffer and follows it through growth, and the text is
+ * kept NUL-terminated, so sb.data can go to C string functions at any point.
+ * Numbers are formatted by hand: no printf, no locale, '.' as the decimal
+ * point. flux_sb_take hands the buffer to the caller; FLUX_TRANSFER(sb.guard)
+ * moves it to the parent scope instead. Like flux_vec, the builder itself
+ * must not be used after its scope exits.
+ *
+ *     flux_sb_t sb;
+ *     flux_sb_init(&sb, 0);
+ *     flux_sb_append(&sb, "id=");
+ *     flux_sb_append_int(&sb, id);
+ */
+typedef struct flux_sb {
+    char* data;
+    size_t len;
+    size_t cap;
+    flux_guard_t* guard;
+} flux_sb_t;
+
+#define FLUX_SB_MIN_CAP 64
+#define FLUX_SB_MAX_PRECISION 17
+
+static const char __flux_digits2[201] =
+    "0001020304050607080910111213141516171819202122232425262728293031323334353637383940414243444546474849"
+    "5051525354555657585960616263646566676869707172737475767778798081828384858687888990919293949596979899";
+
+static const uint64_t __flux_pow10[FLUX_SB_MAX_PRECISION + 1] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull,
+    100000000ull, 1000000000ull, 10000000000ull, 100000000000ull, 1000000000000ull,
+    10000000000000ull, 100000000000000ull, 1000000000000000ull, 10000000000000000ull,
+    100000000000000000ull
+};
+
+/* need counts the terminator; the guard keeps owning the old buffer if realloc fails */
+__attribute__((noinline, cold, unused))
+static void __flux_sb_grow(flux_sb_t* sb, size_t need) {
+    if (!sb->guard) FLUX_THROW_INVALID("flux_sb used after flux_sb_take");
+    size_t cap = sb->cap > SIZE_MAX / 2 ? need : sb->cap * 2;
+    if (cap < FLUX_SB_MIN_CAP) cap = FLUX_SB_MIN_CAP;
+    if (cap < need) cap = need;
+    char* p = (char*)realloc(sb->guard->ptr, cap);
+    if (!p) FLUX_THROW_MEMORY();
+    sb->guard->ptr = p;
+    sb->data = p;
+    sb->cap = cap;
+}
+
+/* room for n more bytes plus the terminator; returns where they go */
+static inline char* flux_sb_reserve(flux_sb_t* sb, size_t n) {
+    if (__builtin_expect(n >= sb->cap - sb->len, 0)) {
+        if (n >= SIZE_MAX - sb->len) FLUX_THROW_LIMIT();
+        __flux_sb_grow(sb, sb->len + n + 1);
+    }
+    return sb->data + sb->len;
+}
+
+static inline void flux_sb_init(flux_sb_t* sb, size_t cap) {
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->guard = FLUX_DEFER_FREE(NULL);
+    if (!sb->guard) FLUX_THROW_INVALID("flux_sb_init outside FLUX_TRY");
+    flux_sb_reserve(sb, cap);
+    sb->data[0] = '\0';
+}
+
+static inline const char* flux_sb_cstr(const flux_sb_t* sb) {
+    return sb->data ? sb->data : "";
+}
+
+static inline void flux_sb_clear(flux_sb_t* sb) {
+    sb->len = 0;
+    if (sb->data) sb->data[0] = '\0';
+}
+
+static inline void flux_sb_appendn(flux_sb_t* sb, const char* s, size_t n) {
+    /* s may point into data, which growing reallocates */
+    uintptr_t off = (uintptr_t)s - (uintptr_t)sb->data;
+    bool self = sb->data && off < sb->len;
+    char* w = flux_sb_reserve(sb, n);
+    if (self) s = sb->data + off;
+    memcpy(w, s, n);
+    sb->len += n;
+    sb->data[sb->len] = '\0';
+}
+
+static inline void flux_sb_append(flux_sb_t* sb, const char* s) {
+    flux_sb_appendn(sb, s, strlen(s));
+}
+
+static inline void flux_sb_putc(flux_sb_t* sb, char c) {
+    char* w = flux_sb_reserve(sb, 1);
+    w[0] = c;
+    w[1] = '\0';
+    sb->len++;
+}
+
+/* writes v in decimal so that it ends just before end, two digits per division */
+static inline char* __flux_utoa(char* end, uint64_t v) {
+    while (v >= 100) {
+        end -= 2;
+        memcpy(end, __flux_digits2 + (v % 100) * 2, 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        end -= 2;
+        memcpy(end, __flux_digits2 + v * 2, 2);
+    } else {
+        *--end = (char)('0' + v);
+    }
+    return end;
+}
+
+static inline void flux_sb_append_uint(flux_sb_t* sb, uint64_t v) {
+    char buf[20];
+    char* p = __flux_utoa(buf + sizeof(buf), v);
+    flux_sb_appendn(sb, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+static inline void flux_sb_append_int(flux_sb_t* sb, int64_t v) {
+    char buf[21];
+    char* p = __flux_utoa(buf + sizeof(buf), v < 0 ? 0 - (uint64_t)v : (uint64_t)v);
+    if (v < 0) *--p = '-';
+    flux_sb_appendn(sb, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/* lowercase, no 0x prefix */
+static inline void flux_sb_append_hex(flux_sb_t* sb, uint64_t v) {
+    char buf[16];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = "0123456789abcdef"[v & 15];
+        v >>= 4;
+    } while (v);
+    flux_sb_appendn(sb, p, (size_t)(buf + sizeof(buf) - p));
+}
+
+/*
+ * Splits v (finite, >= 0, < 2^64) into its integer part and its fraction
+ * times scale, rounded half to even on the exact binary value. The fraction
+ * is m / 2^sh with m < 2^53 and scale <= 10^17, so the product needs up to
+ * 110 bits; it is kept as two 64-bit halves. May return scale (carry).
+ */
+static inline uint64_t __flux_split_double(double v, uint64_t scale, uint64_t* ip) {
+    uint64_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    int bexp = (int)(bits >> 52) & 0x7ff;
+    uint64_t m = bits & ((1ull << 52) - 1);
+    if (bexp) m |= 1ull << 52;
+    int sh = 1075 - (bexp ? bexp : 1);
+    if (sh <= 0) {
+        *ip = m << -sh;
+        return 0;
+    }
+    *ip = sh < 64 ? m >> sh : 0;
+    if (sh < 64) m &= (1ull << sh) - 1;
+    if (sh >= 128 || !m) return 0;
+
+    uint64_t al = m & 0xffffffffu, ah = m >> 32;
+    uint64_t bl = scale & 0xffffffffu, bh = scale >> 32;
+    uint64_t ll = al * bl, lh = al * bh, hl = ah * bl;
+    uint64_t mid = (ll >> 32) + (lh & 0xffffffffu) + (hl & 0xffffffffu);
+    uint64_t lo = (mid << 32) | (ll & 0xffffffffu);
+    uint64_t hi = ah * bh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+    uint64_t q, half, sticky;
+    int r = sh - 1;
+    if (sh < 64) {
+        q = (lo >> sh) | (hi << (64 - sh));
+        half = (lo >> r) & 1;
+        sticky = lo & ((1ull << r) - 1);
+    } else {
+        q = hi >> (sh - 64);
+        if (r < 64) {
+            half = (lo >> r) & 1;
+            sticky = r ? lo & ((1ull << r) - 1) : 0;
+        } else {
+            half = (hi >> (r - 64)) & 1;
+            sticky = lo | (hi & ((1ull << (r - 64)) - 1));
+        }
+    }
+    /* at prec 0 the last digit kept is the integer part's */
+    if (half && (sticky || ((scale == 1 ? *ip : q) & 1))) q++;
+    return q;
+}
+
+/*
+ * prec digits after the point. Below 1e18 the output is that of "%.*f" in
+ * the C locale: the exact binary value is rounded half to even. From 1e18 on
+ * it is d.ddd...e+N, with the mantissa scaled down in double arithmetic, so
+ * its last digits can differ from an exact conversion. nan and inf are
+ * spelled out; prec is clamped to FLUX_SB_MAX_PRECISION.
+ */
+__attribute__((unused))
+static void flux_sb_append_double(flux_sb_t* sb, double v, int prec) {
+    char buf[64];
+    char* w = buf;
+    if (__builtin_isnan(v)) {
+        flux_sb_appendn(sb, "nan", 3);
+        return;
+    }
+    if (__builtin_signbit(v)) {
+        *w++ = '-';
+        v = -v;
+    }
+    if (__builtin_isinf(v)) {
+        memcpy(w, "inf", 3);
+        flux_sb_appendn(sb, buf, (size_t)(w + 3 - buf));
+        return;
+    }
+    if (prec < 0) prec = 0;
+    if (prec > FLUX_SB_MAX_PRECISION) prec = FLUX_SB_MAX_PRECISION;
+
+    int exp10 = 0;
+    if (v >= 1e18) {
+        while (v >= 1e16) { v /= 1e16; exp10 += 16; }
+        while (v >= 10.0) { v /= 10.0; exp10++; }
+    }
+    uint64_t scale = __flux_pow10[prec];
+    uint64_t ip;
+    uint64_t frac = __flux_split_double(v, scale, &ip);
+    if (frac >= scale) {
+        frac -= scale;
+        ip++;
+        if (exp10 && ip == 10) {
+            ip = 1;
+            exp10++;
+        }
+    }
+
+    char digits[20];
+    char* p = __flux_utoa(digits + sizeof(digits), ip);
+    size_t n = (size_t)(digits + sizeof(digits) - p);
+    memcpy(w, p, n);
+    w += n;
+    if (prec) {
+        *w++ = '.';
+        for (int i = prec; i > 0; i--) {
+            w[i - 1] = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        w += prec;
+    }
+    if (exp10) {
+        *w++ = 'e';
+        *w++ = '+';
+        p = __flux_utoa(digits + sizeof(digits), (uint64_t)exp10);
+        n = (size_t)(digits + sizeof(digits) - p);
+        memcpy(w, p, n);
+        w += n;
+    }
+    flux_sb_appendn(sb, buf, (size_t)(w - buf));
+}
+
+/*
+ * Hands the buffer to the caller, who releases it with free(); the guard is
+ * disarmed and sb is left empty and unusable. Never returns NULL.
+ */
+static inline char* flux_sb_take(flux_sb_t* sb) {
+    if (!sb->data) {
+        flux_sb_reserve(sb, 0);
+        sb->data[0] = '\0';
+    }
+    char* p = sb->data;
+    FLUX_DISARM(sb->guard);
+    sb->data = NULL;
+    sb->len = 0;
+    sb->cap = 0;
+    sb->guard = NULL;
+    return p;
+}
+
+/*
+ * Native context switch. Emitted into a COMDAT group so every translation unit
+ * can carry its own copy and the linker keeps one. The .ifndef guards cover
+ * -flto, which hands the asm of every unit to a single assembler run. Unlike
+ * libc setjmp there is no signal mask and no pointer mangling: save is a
+ * handful of stores.
+ */
+#if FLUX_CTX_NATIVE && defined(__x86_64__)
+__asm__(
+    ".ifndef __flux_ctx_save\n"
+    ".pushsection .text.__flux_ctx_save,\"axG\",%progbits,__flux_ctx_save,comdat\n"
+    ".globl __flux_ctx_save\n"
+    ".hidden __flux_ctx_save\n"
+    ".type __flux_ctx_save,%function\n"
+    ".p2align 4\n"
+    "__flux_ctx_save:\n"
+    ".cfi_startproc\n"
+    "    movq %rbx, 0(%rdi)\n"
+    "    movq %rbp, 8(%rdi)\n"
+    "    movq %r12, 16(%rdi)\n"
+    "    movq %r13, 24(%rdi)\n"
+    "    movq %r14, 32(%rdi)\n"
+    "    movq %r15, 40(%rdi)\n"
+    "    leaq 8(%rsp), %rdx\n"
+    "    movq %rdx, 48(%rdi)\n"
+    "    movq (%rsp), %rdx\n"
+    "    movq %rdx, 56(%rdi)\n"
+#if defined(__CET__) && (__CET__ & 2)
+    "    xorl %edx, %edx\n"
+    "    rdsspq %rdx\n"
+    "    movq %rdx, 64(%rdi)\n"
+#endif
+    "    xorl %eax, %eax\n"
+    "    ret\n"
+    ".cfi_endproc\n"
+    ".size __flux_ctx_save, .-__flux_ctx_save\n"
+    ".popsection\n"
+    ".endif\n"
+    ".ifndef __flux_ctx_jump\n"
+    ".pushsection .text.__flux_ctx_jump,\"axG\",%progbits,__flux_ctx_jump,comdat\n"
+    ".globl __flux_ctx_jump\n"
+    ".hidden __flux_ctx_jump\n"
+    ".type __flux_ctx_jump,%function\n"
+    ".p2align 4\n"
+    "__flux_ctx_jump:\n"
+    ".cfi_startproc\n"
+#if defined(__CET__) && (__CET__ & 2)
+    /* pop the shadow stack back to the saved frame (+8 for the save's own return) */
+    "    xorl %edx, %edx\n"
+    "    rdsspq %rdx\n"
+    "    testq %rdx, %rdx\n"
+    "    jz 2f\n"
+    "    movq 64(%rdi), %rcx\n"
+    "    addq $8, %rcx\n"
+    "    subq %rdx, %rcx\n"
+    "    shrq $3, %rcx\n"
+    "    movl $255, %edx\n"
+    "1:  cmpq %rdx, %rcx\n"
+    "    cmovbq %rcx, %rdx\n"
+    "    incsspq %rdx\n"
+    "    subq %rdx, %rcx\n"
+    "    jnz 1b\n"
+    "2:\n"
+#endif
+    "    movl %esi, %eax\n"
+    "    testl %eax, %eax\n"
+    "    jnz 3f\n"
+    "    incl %eax\n"
+    "3:  movq 0(%rdi), %rbx\n"
+    "    movq 8(%rdi), %rbp\n"
+    "    movq 16(%rdi), %r12\n"
+    "    movq 24(%rdi), %r13\n"
+    "    movq 32(%rdi), %r14\n"
+    "    movq 40(%rdi), %r15\n"
+    "    movq 48(%rdi), %rsp\n"
+    "    jmpq *56(%rdi)\n"
+    ".cfi_endproc\n"
+    ".size __flux_ctx_jump, .-__flux_ctx_jump\n"
+    ".popsection\n"
+    ".endif\n"
+);
+#elif FLUX_CTX_NATIVE && defined(__aarch64__)
+__asm__(
+    ".ifndef __flux_ctx_save\n"
+    ".pushsection .text.__flux_ctx_save,\"axG\",%progbits,__flux_ctx_save,comdat\n"
+    ".globl __flux_ctx_save\n"
+    ".hidden __flux_ctx_save\n"
+    ".type __flux_ctx_save,%function\n"
+    ".p2align 4\n"
+    "__flux_ctx_save:\n"
+    ".cfi_startproc\n"
+#if defined(__ARM_FEATURE_BTI_DEFAULT) && __ARM_FEATURE_BTI_DEFAULT
+    "    hint #34\n"
+#endif
+    "    stp x19, x20, [x0, #0]\n"
+    "    stp x21, x22, [x0, #16]\n"
+    "    stp x23, x24, [x0, #32]\n"
+    "    stp x25, x26, [x0, #48]\n"
+    "    stp x27, x28, [x0, #64]\n"
+    "    stp x29, x30, [x0, #80]\n"
+    "    mov x2, sp\n"
+    "    str x2, [x0, #96]\n"
+    "    stp d8, d9, [x0, #104]\n"
+    "    stp d10, d11, [x0, #120]\n"
+    "    stp d12, d13, [x0, #136]\n"
+    "    stp d14, d15, [x0, #152]\n"
+    "    mov w0, #0\n"
+    "    ret\n"
+    ".cfi_endproc\n"
+    ".size __flux_ctx_save, .-__flux_ctx_save\n"
+    ".popsection\n"
+    ".endif\n"
+    ".ifndef __flux_ctx_jump\n"
+    ".pushsection .text.__flux_ctx_jump,\"axG\",%progbits,__flux_ctx_jump,comdat\n"
+    ".globl __flux_ctx_jump\n"
+    ".hidden __flux_ctx_jump\n"
+    ".type __flux_ctx_jump,%function\n"
+    ".p2align 4\n"
+    "__flux_ctx_jump:\n"
+    ".cfi_startproc\n"
+#if defined(__ARM_FEATURE_BTI_DEFAULT) && __ARM_FEATURE_BTI_DEFAULT
+    "    hint #34\n"
+#endif
+    "    ldp x19, x20, [x0, #0]\n"
+    "    ldp x21, x22, [x0, #16]\n"
+    "    ldp x23, x24, [x0, #32]\n"
+    "    ldp x25, x26, [x0, #48]\n"
+    "    ldp x27, x28, [x0, #64]\n"
+    "    ldp x29, x30, [x0, #80]\n"
+    "    ldr x2, [x0, #96]\n"
+    "    mov sp, x2\n"
+    "    ldp d8, d9, [x0, #104]\n"
+    "    ldp d10, d11, [x0, #120]\n"
+    "    ldp d12, d13, [x0, #136]\n"
+    "    ldp d14, d15, [x0, #152]\n"
+    "    cmp w1, #0\n"
+    "    csinc w0, w1, wzr, ne\n"
+    "    ret\n"
+    ".cfi_endproc\n"
+    ".size __flux_ctx_jump, .-__flux_ctx_jump\n"
+    ".popsection\n"
+    ".endif\n"
+);
 #endif
 
 #endif /* LIBFLUX_H */
\ No newline at end of file
@@ -1,13 +1,57 @@
 // this is test file and example for use library libflux.h
 #include "libflux.h"
 
+static char released[32];
+
+static void note_release(void* tag) {
+    size_t n = strlen(released);
+    released[n] = *(const char*)tag;
+    released[n + 1] = '\0';
+}
+
+/* builds its result with FLUX_MALLOC_H and disarms the guard to hand the buffer to the caller */
+static char* make_greeting(const char* name) {
+    char* volatile out = NULL;
+    FLUX_TRY {
+        flux_guard_t* h;
+        char* buf = (char*)FLUX_MALLOC_H(64, h);
+        snprintf(buf, 64, "hello, %s", name);
+        FLUX_DISARM(h);
+        out = buf;
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+    } FLUX_END_TRY;
+    return out;
+}
+
+/* throws fmt with FLUX_THROWF and counts a mismatch against snprintf in *bad */
+#define CHECK_THROWF(bad, fmt, ...) do { \
+    char want[64]; \
+    snprintf(want, sizeof(want), fmt, __VA_ARGS__); \
+    FLUX_TRY { \
+        FLUX_THROWF(4, fmt, __VA_ARGS__); \
+    } FLUX_CATCH(e) { \
+        if (strcmp(flux_error_message(e), want) != 0) { \
+            printf("❌ FLUX_THROWF(\"%s\"): %s, printf gives %s\n", fmt, flux_error_message(e), want); \
+            (bad)++; \
+        } \
+    } FLUX_END_TRY; \
+} while(0)
+
+typedef struct { uint64_t words[9]; } wide_t;
+
+FLUX_VEC_DEFINE(int_vec, int)
+FLUX_VEC_DEFINE(wide_vec, wide_t)
+
 int main(void) {
     FLUX_TRY {
-        char* buffer = (char*)FLUX_MALLOC(1024);
+        flux_sb_t msg;
+        flux_sb_init(&msg, 0);
         FILE* f = FLUX_FOPEN("test.txt", "w");
         fprintf(f, "Hello from libflux!\n");
-        snprintf(buffer, 1024, "Data processed at %p", (void*)buffer);
-        printf("✅ %s\n", buffer);
+        flux_sb_append(&msg, "Data processed at 0x");
+        flux_sb_append_hex(&msg, (uintptr_t)msg.data);
+        printf("✅ %s\n", flux_sb_cstr(&msg));
     } FLUX_CATCH(e) {
         flux_error_print(e);
         return 1;
@@ -30,6 +74,241 @@ int main(void) {
         flux_error_print(e);
     } FLUX_END_TRY;
 
+    volatile int bad_formats = 0;
+    CHECK_THROWF(bad_formats, "%x %u", -1, -1);
+    CHECK_THROWF(bad_formats, "%08x %X", (int)0x80004005, -2);
+    CHECK_THROWF(bad_formats, "%d %lu", 3000000000u, -1L);
+    CHECK_THROWF(bad_formats, "%hd %hx %hhd %hhx", 70000, (short)-2, 300, -1);
+    CHECK_THROWF(bad_formats, "%lld %zu %jx", -5LL, (size_t)-1, (intmax_t)-1);
+    if (bad_formats) return 1;
+    printf("✅ Deferred error formats match printf\n");
+
+    FLUX_TRY {
+        FLUX_DEFER(note_release, "x");
+        FLUX_DEFER(note_release, "y");
+        FLUX_DEFER(note_release, "z");
+        FLUX_TRY {
+            const char* tags[] = { "a", "b", "c", "d", "e", "f" };
+            for (int i = 0; i < 6; i++) {
+                flux_guard_t* g = FLUX_DEFER(note_release, tags[i]);
+                if (i % 2 == 0) FLUX_TRANSFER(g);
+            }
+        } FLUX_CATCH(e) {
+            flux_error_print(e);
+        } FLUX_END_TRY;
+        FLUX_DEFER(note_release, "g");
+        FLUX_THROW_INVALID("unwinding the outer scope");
+    } FLUX_CATCH(e) {
+        (void)e;
+    } FLUX_END_TRY;
+
+    FLUX_TRY {
+        FLUX_TRY {
+            FLUX_TRANSFER(FLUX_DEFER(note_release, "h"));
+            FLUX_DEFER(note_release, "i");
+            FLUX_THROW_INVALID("inner failure");
+        } FLUX_CATCH(e) {
+            (void)e;
+            note_release("!");
+        } FLUX_END_TRY;
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
+    if (strcmp(released, "fdbgecazyxi!h") != 0) {
+        printf("❌ Transferred guards released out of order: %s\n", released);
+        return 1;
+    }
+    printf("✅ Transferred guards released by the enclosing scope in order\n");
+
+    char* greeting = make_greeting("flux");
+    if (!greeting || strcmp(greeting, "hello, flux") != 0) {
+        printf("❌ Returned FLUX_MALLOC buffer lost\n");
+        return 1;
+    }
+    free(greeting);
+    printf("✅ FLUX_MALLOC buffer returned to the caller\n");
+
+    FLUX_TRY {
+        flux_guard_t* h = NULL;
+        size_t cap = 16;
+        int* grown = (int*)FLUX_REALLOC_GUARD(h, cap * sizeof(int));
+        flux_guard_t* first = h;
+        for (size_t i = 0; i < 4096; i++) {
+            if (i == cap) grown = (int*)FLUX_REALLOC_GUARD(h, (cap *= 2) * sizeof(int));
+            grown[i] = (int)i;
+        }
+        flux_guard_t* mh;
+        char* text = (char*)FLUX_MALLOC_H(8, mh);
+        for (size_t n = 16; n <= 8192; n *= 2) {
+            text = (char*)FLUX_REALLOC(text, n);
+            text[n - 1] = 'x';
+        }
+        if (h != first || h->ptr != grown || mh->ptr != text || grown[4095] != 4095)
+            FLUX_THROW_INVALID("regrown buffers did not keep their guards");
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+    printf("✅ Regrown buffers kept one guard each\n");
+
+    FLUX_TRY {
+        char* outer = (char*)FLUX_ARENA_ALLOC(256);
+        memset(outer, 'o', 256);
+        FLUX_TRY {
+            for (int i = 0; i < 3; i++) memset(FLUX_ARENA_ALLOC(FLUX_ARENA_BLOCK_SIZE / 2), 'i', FLUX_ARENA_BLOCK_SIZE / 2);
+            memset(FLUX_ARENA_ALLOC(FLUX_ARENA_BLOCK_SIZE * 2), 'I', FLUX_ARENA_BLOCK_SIZE * 2);
+        } FLUX_CATCH(e) {
+            flux_error_print(e);
+            FLUX_THROW_INVALID("inner arena scope failed");
+        } FLUX_END_TRY;
+        char* after = (char*)FLUX_ARENA_ALLOC(256);
+        memset(after, 'a', 256);
+        for (int i = 0; i < 256; i++) {
+            if (outer[i] != 'o') FLUX_THROW_INVALID("outer arena data overwritten by a nested scope");
+        }
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+    printf("✅ Outer arena data intact after a nested scope grew past one block\n");
+
+    FLUX_TRY {
+        int_vec iv;
+        int_vec_init(&iv, 0);
+        for (int i = 0; i < 1000; i++) int_vec_push(&iv, i);
+        int_vec_extend(&iv, iv.data, 500);
+        wide_vec wv;
+        wide_vec_init(&wv, 0);
+        for (uint64_t i = 0; i < 100; i++) wide_vec_push(&wv, (wide_t){ { i, [8] = ~i } });
+        bool ok = iv.len == 1500 && wv.len == 100 && iv.cap >= iv.len && wv.cap >= wv.len &&
+                  (uintptr_t)iv.data % FLUX_VEC_ALIGN == 0 && (uintptr_t)wv.data % FLUX_VEC_ALIGN == 0;
+        for (size_t i = 0; ok && i < iv.len; i++) ok = iv.data[i] == (int)(i % 1000);
+        for (uint64_t i = 0; ok && i < wv.len; i++) ok = wv.data[i].words[0] == i && wv.data[i].words[8] == ~i;
+        if (!ok) FLUX_THROW_INVALID("vector contents or alignment wrong");
+        printf("✅ Vectors grown to %zu ints and %zu wide elements\n", iv.len, wv.len);
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
+    FLUX_TRY {
+        void* a64 = FLUX_ALIGNED_ALLOC(64, 100);
+        void* a4k = FLUX_ALIGNED_ALLOC(4096, 100);
+        void* r64 = FLUX_ARENA_ALLOC_ALIGNED(64, 100);
+        void* r4k = FLUX_ARENA_ALLOC_ALIGNED(4096, 100);
+        unsigned char* zeros = (unsigned char*)FLUX_ALIGNED_CALLOC(64, 333, 3);
+        if ((uintptr_t)a64 % 64 || (uintptr_t)a4k % 4096 || (uintptr_t)r64 % 64 || (uintptr_t)r4k % 4096 ||
+            (uintptr_t)zeros % 64)
+            FLUX_THROW_INVALID("aligned block misaligned");
+        for (size_t i = 0; i < 333 * 3; i++) {
+            if (zeros[i]) FLUX_THROW_INVALID("FLUX_ALIGNED_CALLOC block not zeroed");
+        }
+        volatile int rejected = 0;
+        FLUX_TRY {
+            FLUX_ALIGNED_ALLOC(48, 100);
+        } FLUX_CATCH(e) {
+            rejected += e->code == 4;
+        } FLUX_END_TRY;
+        FLUX_TRY {
+            FLUX_ARENA_ALLOC_ALIGNED(96, 100);
+        } FLUX_CATCH(e) {
+            rejected += e->code == 4;
+        } FLUX_END_TRY;
+        if (rejected != 2) FLUX_THROW_INVALID("non-power-of-two alignment accepted");
+        printf("✅ Aligned blocks at 64 and 4096 bytes, zeroed, bad alignments rejected\n");
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
+    FLUX_TRY {
+        flux_map_t* ids = flux_map_new_int(0);
+        flux_map_t* names = flux_map_new_str(0);
+        char key[32];
+        for (uint64_t i = 0; i < 5000; i++) {
+            flux_map_put_int(ids, i << 16, (void*)(uintptr_t)(i + 1));
+            snprintf(key, sizeof(key), "key%llu", (unsigned long long)i);
+            flux_map_put_str(names, key, (void*)(uintptr_t)(i + 1));
+        }
+        for (uint64_t i = 0; i < 5000; i += 2) {
+            flux_map_put_int(ids, i << 16, (void*)(uintptr_t)(i + 2));
+            snprintf(key, sizeof(key), "key%llu", (unsigned long long)i);
+            *flux_map_find_str(names, key) = (void*)(uintptr_t)(i + 2);
+        }
+        bool ok = flux_map_len(ids) == 5000 && flux_map_len(names) == 5000 &&
+                  !flux_map_find_int(ids, 1) && !flux_map_find_int(ids, 5000 << 16) &&
+                  !flux_map_find_str(names, "key") && !flux_map_find_str(names, "key5000") &&
+                  flux_map_find_strn(names, "key12", 4) && !flux_map_find_strn(names, "key12", 3);
+        for (uint64_t i = 0; ok && i < 5000; i++) {
+            uintptr_t want = i + 1 + (i % 2 == 0);
+            void** v = flux_map_find_int(ids, i << 16);
+            snprintf(key, sizeof(key), "key%llu", (unsigned long long)i);
+            void** n = flux_map_find_str(names, key);
+            ok = v && n && (uintptr_t)*v == want && (uintptr_t)*n == want;
+        }
+        if (!ok) FLUX_THROW_INVALID("map lookups wrong");
+        volatile int rejected = 0;
+        FLUX_TRY {
+            flux_map_find_int(names, 1);
+        } FLUX_CATCH(e) {
+            rejected += e->code == 4;
+        } FLUX_END_TRY;
+        FLUX_TRY {
+            flux_map_put_str(ids, "key1", NULL);
+        } FLUX_CATCH(e) {
+            rejected += e->code == 4;
+        } FLUX_END_TRY;
+        if (rejected != 2) FLUX_THROW_INVALID("map used with the wrong key kind");
+        printf("✅ Maps hold %zu int and %zu string keys\n", flux_map_len(ids), flux_map_len(names));
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
+    FLUX_TRY {
+        flux_sb_t sb;
+        flux_sb_init(&sb, 0);
+        flux_sb_append(&sb, "ab");
+        for (int i = 0; i < 12; i++) flux_sb_appendn(&sb, sb.data, sb.len);
+        flux_sb_appendn(&sb, sb.data + 1, 3);
+        bool ok = sb.len == (2u << 12) + 3 && strcmp(sb.data + sb.len - 3, "bab") == 0;
+        for (size_t i = 0; ok && i < sb.len - 3; i++) ok = sb.data[i] == "ab"[i % 2];
+        if (!ok) FLUX_THROW_INVALID("string builder appended to itself wrong");
+        printf("✅ String builder doubled from its own buffer to %zu bytes\n", sb.len);
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
+    FLUX_TRY {
+        static const double values[] = {
+            0.0, -0.0, 0.5, 1.5, 2.5, -2.5, 0.125, 0.375, 0.045, 1.005, 2.675, 0.1, 1.0 / 3,
+            123456.789, -9.9999999, 4503599627370495.5, 999999999999999872.0, 5e-324, 1e-7,
+        };
+        flux_sb_t sb;
+        flux_sb_init(&sb, 0);
+        char want[64];
+        int mismatches = 0;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+            for (int prec = 0; prec <= FLUX_SB_MAX_PRECISION; prec++) {
+                flux_sb_clear(&sb);
+                flux_sb_append_double(&sb, values[i], prec);
+                snprintf(want, sizeof(want), "%.*f", prec, values[i]);
+                if (strcmp(flux_sb_cstr(&sb), want) != 0) {
+                    printf("❌ %.17g at %d digits: %s, printf gives %s\n", values[i], prec, flux_sb_cstr(&sb), want);
+                    mismatches++;
+                }
+            }
+        }
+        if (mismatches) FLUX_THROW_INVALID("doubles formatted unlike printf");
+        printf("✅ Doubles formatted like printf\n");
+    } FLUX_CATCH(e) {
+        flux_error_print(e);
+        return 1;
+    } FLUX_END_TRY;
+
     printf("✨ All tests passed — zero leaks, full control.\n");
     return 0;
 }
\ No newline at end of file